@@ -0,0 +1,48 @@
+// libFuzzer target: arbitrary ROM bytes and keypad input into a headless Chip8
+//
+// input layout:
+//   [0]              quirk profile, modulo QUIRKS_COUNT
+//   [1]              n, number of keypad states
+//   [2, 2 + 2n)      keypad states, 16-bit little endian (bit k = key k held),
+//                    each held for FUZZ_FRAME_CYCLES cycles, the last one stays
+//   [2 + 2n, end)    ROM, loaded at 0x200
+
+#include "../src/Chip8.h"
+
+#include <cstddef>
+#include <cstdint>
+
+const int FUZZ_FRAME_CYCLES = 16;
+const int FUZZ_MAX_CYCLES   = 256;  // per input, short runs keep exec/s high
+
+// reset, not rebuilt, between inputs
+static Chip8 chip8;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 2) return 0;
+    Quirks quirks = (Quirks)(data[0] % QUIRKS_COUNT);
+    size_t frames = data[1];
+    if (size < 2 + 2 * frames) return 0;
+    const uint8_t* keys     = data + 2;
+    const uint8_t* rom      = keys + 2 * frames;
+    size_t         rom_size = size - 2 - 2 * frames;
+
+    bool success = true;
+    chip8.Reset();
+    chip8.Seed(0);
+    chip8.LoadROM(rom, rom_size, success);
+    if (!success) return 0; // too large
+    chip8.SetQuirks(quirks);
+
+    for (int cycle = 0; cycle < FUZZ_MAX_CYCLES && success; cycle ++) {
+        size_t frame = cycle / FUZZ_FRAME_CYCLES;
+        if (cycle % FUZZ_FRAME_CYCLES == 0 && frame < frames) {
+            uint16_t state = keys[2 * frame] | (keys[2 * frame + 1] << 8);
+            for (int key = 0; key < 16; key ++) {
+                chip8.keypad[key] = (state >> key) & 1;
+            }
+        }
+        chip8.Cycle(success); // an invalid pc just ends the run
+    }
+    return 0;
+}
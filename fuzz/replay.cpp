@@ -0,0 +1,119 @@
+// Standalone driver for fuzz_chip8.cpp when libFuzzer is not available
+// (e.g. a g++-only machine): replays files/directories through the target,
+// optionally followed by N random mutations of them. Build it with the
+// sanitizers and run it with abort_on_error=1 (see `make fuzz-replay`);
+// a crashing input is then saved as ./crash-input.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // strcmp()
+#include <csignal>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+const size_t FUZZ_MAX_LEN = 4096; // 2 + 2 * 255 keypad states + a full ROM, rounded
+
+static std::vector<uint8_t> current; // input being run, for the crash file
+static uint64_t             executions = 0;
+
+// signal handler, so only async-signal-safe calls
+static void SaveCrash(int signal) {
+    int fd = open("crash-input", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        ssize_t written = write(fd, current.data(), current.size());
+        close(fd);
+        const char message[] = "==== input written to crash-input\n";
+        if (written >= 0) written = write(STDERR_FILENO, message, sizeof(message) - 1);
+    }
+    std::signal(signal, SIG_DFL);
+    raise(signal);
+}
+
+static void Run(const std::vector<uint8_t> &input) {
+    current = input;
+    LLVMFuzzerTestOneInput(current.data(), current.size());
+    executions ++;
+}
+
+static void Load(const std::string &path, std::vector<std::vector<uint8_t>> &inputs) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return;
+
+    if (S_ISDIR(info.st_mode)) {
+        DIR* dir = opendir(path.c_str());
+        if (dir == nullptr) return;
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') Load(path + "/" + entry->d_name, inputs);
+        }
+        closedir(dir);
+        return;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    inputs.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (inputs.back().size() > FUZZ_MAX_LEN) inputs.back().resize(FUZZ_MAX_LEN);
+}
+
+// a few random byte flips, overwrites, inserts or erases
+static void Mutate(std::vector<uint8_t> &input, std::mt19937 &rng) {
+    int edits = 1 + rng() % 4;
+    for (int i = 0; i < edits; i ++) {
+        size_t at = input.empty() ? 0 : rng() % input.size();
+        switch (rng() % 4) {
+            case 0: if (!input.empty()) input[at] ^= 1 << (rng() % 8);              break;
+            case 1: if (!input.empty()) input[at] = rng();                           break;
+            case 2: if (input.size() < FUZZ_MAX_LEN) input.insert(input.begin() + at, rng()); break;
+            case 3: if (!input.empty()) input.erase(input.begin() + at);             break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::vector<uint8_t>> inputs;
+    uint64_t mutations = 0;
+
+    for (int i = 1; i < argc; i ++) {
+        if (strcmp(argv[i], "--mutate") == 0 && i + 1 < argc) {
+            try {
+                mutations = std::stoull(argv[++ i]);
+            } catch (std::logic_error const& ex) {
+                printf("Invalid count '%s'.\n", argv[i]);
+                return 1;
+            }
+        } else {
+            Load(argv[i], inputs);
+        }
+    }
+    if (inputs.empty()) {
+        printf("Usage: %s <file|dir>... [--mutate N]\n", argv[0]);
+        return 1;
+    }
+
+    std::signal(SIGABRT, SaveCrash);
+    std::signal(SIGSEGV, SaveCrash);
+    auto start = std::chrono::steady_clock::now();
+
+    for (const std::vector<uint8_t> &input : inputs) Run(input);
+
+    std::mt19937 rng(0);
+    for (uint64_t i = 0; i < mutations; i ++) {
+        std::vector<uint8_t> input = inputs[rng() % inputs.size()];
+        Mutate(input, rng);
+        Run(input);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%llu inputs in %.2f s (%.0f exec/s), no crashes\n",
+           (unsigned long long)executions, seconds, executions / seconds);
+    return 0;
+}
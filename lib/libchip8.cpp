@@ -0,0 +1,78 @@
+#include "libchip8.h"
+#include "../src/Chip8.h"
+
+#include <cstdint>
+#include <new>
+
+static_assert(CHIP8_WIDTH == VIDEO_WIDTH && CHIP8_HEIGHT == VIDEO_HEIGHT,
+              "libchip8.h screen size out of sync with Chip8.h");
+
+struct chip8 {
+    Chip8    core;
+    unsigned cycles_per_frame = CHIP8_CYCLES_PER_FRAME;
+    uint64_t cycles           = 0;
+    bool     running          = true; // false once pc became invalid
+};
+
+
+chip8_t* chip8_create(uint32_t seed) {
+    chip8_t* chip8 = new (std::nothrow) chip8_t;
+    if (chip8 != nullptr) chip8->core.Seed(seed);
+    return chip8;
+}
+
+void chip8_destroy(chip8_t* chip8) {
+    delete chip8;
+}
+
+int chip8_load_rom(chip8_t* chip8, const uint8_t* data, size_t size) {
+    bool success = true;
+    chip8->core.LoadROM(data, size, success);
+    return success ? 0 : -1;
+}
+
+int chip8_set_quirks(chip8_t* chip8, const char* name) {
+    Quirks quirks;
+    if (!QuirksByName(name, quirks)) return -1;
+    chip8->core.SetQuirks(quirks);
+    return 0;
+}
+
+void chip8_set_keys(chip8_t* chip8, uint16_t keys) {
+    for (int i = 0; i < 16; i ++) {
+        chip8->core.keypad[i] = (keys >> i) & 1;
+    }
+}
+
+void chip8_set_cycles_per_frame(chip8_t* chip8, unsigned cycles) {
+    chip8->cycles_per_frame = cycles;
+}
+
+int chip8_step_frames(chip8_t* chip8, unsigned frames) {
+    uint64_t cycles = (uint64_t)frames * chip8->cycles_per_frame;
+    for (uint64_t i = 0; i < cycles && chip8->running; i ++) {
+        chip8->core.Cycle(chip8->running);
+        chip8->cycles ++;
+    }
+    return chip8->running ? 0 : -1;
+}
+
+uint64_t chip8_cycles(const chip8_t* chip8) {
+    return chip8->cycles;
+}
+
+void chip8_read_framebuffer(const chip8_t* chip8, uint8_t* out) {
+    chip8->core.PackVideo(out);
+}
+
+int chip8_hires(const chip8_t* chip8) {
+    return chip8->core.hires ? 1 : 0;
+}
+
+chip8_t* chip8_clone(const chip8_t* chip8) {
+    return new (std::nothrow) chip8_t(*chip8);
+}
+
+void chip8_restore(chip8_t* chip8, const chip8_t* from) {
+    *chip8 = *from;
+}
@@ -0,0 +1,69 @@
+#ifndef __LIBCHIP8_H__
+#define __LIBCHIP8_H__
+
+/* C API of libchip8: the interpreter without the ncurses front end.
+ *
+ * Every instance is independent (no shared state), so callers can run one
+ * instance per thread. Link with `-lchip8 -lstdc++` for the static library,
+ * or just `-lchip8` for the shared one.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define CHIP8_API __attribute__((visibility("default")))
+#else
+#define CHIP8_API
+#endif
+
+/* the framebuffer is SUPER-CHIP sized; in lo-res (64x32) mode every
+ * pixel is a 2x2 block of it */
+#define CHIP8_WIDTH             128
+#define CHIP8_HEIGHT            64
+/* 1 bit per pixel, row-major, most significant bit = leftmost pixel */
+#define CHIP8_FRAMEBUFFER_SIZE  (CHIP8_WIDTH * CHIP8_HEIGHT / 8)
+/* the emulator presents the screen after every cycle */
+#define CHIP8_CYCLES_PER_FRAME  1
+
+typedef struct chip8 chip8_t;
+
+/* new machine with fonts loaded and pc at 0x200, NULL on allocation failure */
+CHIP8_API chip8_t* chip8_create(uint32_t seed);
+CHIP8_API void     chip8_destroy(chip8_t* chip8);
+
+/* copy a ROM image to 0x200, return 0 on success, -1 if it does not fit */
+CHIP8_API int      chip8_load_rom(chip8_t* chip8, const uint8_t* data, size_t size);
+/* quirk profile to run with ("default" until set):
+ * "default", "cosmac", "schip" or "xochip", return -1 if unknown */
+CHIP8_API int      chip8_set_quirks(chip8_t* chip8, const char* name);
+
+/* bit n set ==> key n held down */
+CHIP8_API void     chip8_set_keys(chip8_t* chip8, uint16_t keys);
+/* cycles executed per chip8_step_frames() frame, default CHIP8_CYCLES_PER_FRAME */
+CHIP8_API void     chip8_set_cycles_per_frame(chip8_t* chip8, unsigned cycles);
+
+/* run `frames` frames, return 0 on success, -1 once pc became invalid */
+CHIP8_API int      chip8_step_frames(chip8_t* chip8, unsigned frames);
+/* cycles executed since chip8_create() */
+CHIP8_API uint64_t chip8_cycles(const chip8_t* chip8);
+
+/* pack the screen into `out` (CHIP8_FRAMEBUFFER_SIZE bytes) */
+CHIP8_API void     chip8_read_framebuffer(const chip8_t* chip8, uint8_t* out);
+/* 1 while the ROM runs in hi-res (128x64) mode, 0 in lo-res */
+CHIP8_API int      chip8_hires(const chip8_t* chip8);
+
+/* independent copy of the whole machine, NULL on allocation failure */
+CHIP8_API chip8_t* chip8_clone(const chip8_t* chip8);
+/* overwrite `chip8` with the state of `from` (i.e. an earlier clone) */
+CHIP8_API void     chip8_restore(chip8_t* chip8, const chip8_t* from);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBCHIP8_H__ */
@@ -1,8 +1,12 @@
 #include "Chip8.h"
+#include "Hash.h"
+#ifndef NO_TRACE
+#include "Trace.h"
+#endif
 
 #include <chrono>
 #include <cstdint>
-#include <cstring> // memset()
+#include <cstring> // memset(), memcpy()
 #include <fstream>
 #include <random>
 #include <string>
@@ -12,22 +16,57 @@
 
 
 Chip8::Chip8() {
-    // Initialize OPTable
-    Init_OPTable();
-
     // Initialize RNG
     rand_gen.seed( std::chrono::system_clock::now().time_since_epoch().count() );
     rand_byte = std::uniform_int_distribution<uint8_t>(0, 0xFF);
 
+    // Initialize OPTable
+    Init_OPTable();
+    Reset();
+}
+
+// Back to power-on state in place (RNG and tracer are kept)
+void Chip8::Reset() {
+    Use_Quirks<QUIRKS_DEFAULT>();
+    quirks = QUIRKS_DEFAULT;
+
+    memset(registers, 0, sizeof(registers));
+    memset(stack,     0, sizeof(stack));
+    memset(keypad,    0, sizeof(keypad));
+    memset(rpl,       0, sizeof(rpl));
+    // video and memory are most of the state, but a run touches little of them
+    for (int y = 0; y < VIDEO_HEIGHT; y ++) {
+        if (video_dirty & (1ull << y)) memset(video[y], 0, sizeof(video[y]));
+    }
+    for (int page = 0; page < 16; page ++) {
+        if (memory_dirty & (1 << page)) memset(&memory[page * 256], 0, 256);
+    }
+    hires       = false;
+    index       = 0;
+    sp          = 0;
+    delay_timer = 0;
+    sound_timer = 0;
+    opcode      = 0;
 
     // Initialize pc
     pc = START_ADDRESS;
 
-    // Load fonts into memory
-    for (uint16_t i = 0; i < FONTSET_SIZE; i ++) {
-        memory[FONTSET_START_ADDRESS + i] = fontset[i];
+    // Load fonts into memory, unless their pages were left alone
+    if (memory_dirty & 0x0003) {
+        for (uint16_t i = 0; i < FONTSET_SIZE; i ++) {
+            memory[FONTSET_START_ADDRESS + i] = fontset[i];
+        }
+        for (uint16_t i = 0; i < BIGFONT_SIZE; i ++) {
+            memory[BIGFONT_START_ADDRESS + i] = bigfont[i];
+        }
     }
+    memory_dirty = 0;
+    video_dirty  = 0;
+}
 
+// note the memory pages a store of `length` bytes at `at` reaches
+void Chip8::Touch(uint16_t at, uint16_t length) {
+    memory_dirty |= (1 << ((at & 0x0FFF) >> 8)) | (1 << (((at + length - 1) & 0x0FFF) >> 8));
 }
 
 void Chip8::LoadROM(const std::string filename, bool &success) {
@@ -44,10 +83,7 @@ void Chip8::LoadROM(const std::string filename, bool &success) {
         file.read(buffer, size);
         file.close();
 
-        // load ROM to memory, starting at 0x200
-        for (unsigned long i = 0; i < size; i ++) {
-            memory[START_ADDRESS + i] = buffer[i];
-        }
+        LoadROM(reinterpret_cast<uint8_t*>(buffer), size, success);
 
         delete[] buffer;
     } else {
@@ -55,6 +91,44 @@ void Chip8::LoadROM(const std::string filename, bool &success) {
     }
 }
 
+void Chip8::LoadROM(const uint8_t* data, size_t size, bool &success) {
+    // ROM does not fit between 0x200 and the end of memory
+    if (size > sizeof(memory) - START_ADDRESS) {
+        success = false;
+        return;
+    }
+
+    // load ROM to memory, starting at 0x200
+    for (size_t i = 0; i < size; i ++) {
+        memory[START_ADDRESS + i] = data[i];
+    }
+    for (size_t at = START_ADDRESS; at < START_ADDRESS + size; at += 256) Touch(at, 1);
+    if (size > 0) Touch(START_ADDRESS + size - 1, 1);
+}
+
+// Switch the quirk-dependent opcode handlers (no cost per instruction)
+void Chip8::SetQuirks(Quirks profile) {
+    switch (profile) {
+        case QUIRKS_COSMAC: Use_Quirks<QUIRKS_COSMAC>();  break;
+        case QUIRKS_SCHIP:  Use_Quirks<QUIRKS_SCHIP>();   break;
+        case QUIRKS_XOCHIP: Use_Quirks<QUIRKS_XOCHIP>();  break;
+        default:            Use_Quirks<QUIRKS_DEFAULT>(); profile = QUIRKS_DEFAULT; break;
+    }
+    quirks = profile;
+}
+
+// point the quirk-dependent OPTable entries at profile P's handlers
+template <Quirks P>
+void Chip8::Use_Quirks() {
+    typedef QuirksPolicy<P> Q;
+    OPTable[0xB]    = &Chip8::OP_Bnnn<Q>;
+    OPTable[0xD]    = &Chip8::OP_Dxyn<Q>;
+    OPTable_8[0x6]  = &Chip8::OP_8xy6<Q>;
+    OPTable_8[0xE]  = &Chip8::OP_8xyE<Q>;
+    OPTable_F[0x55] = &Chip8::OP_Fx55<Q>;
+    OPTable_F[0x65] = &Chip8::OP_Fx65<Q>;
+}
+
 // Fetch ==> Decode ==> Execute
 void Chip8::Cycle(bool &success) {
     // invalid pc
@@ -66,6 +140,7 @@ void Chip8::Cycle(bool &success) {
     // Fetch
     // concat [pc] and [pc+1] ==> 16-bit opcode
     opcode = (memory[pc] << 8) | memory[pc + 1];
+    uint16_t pc_fetched = pc;
 
     // move pc to next instruction before doing anything
     pc += 2;
@@ -73,11 +148,83 @@ void Chip8::Cycle(bool &success) {
     // Decode & Execute
     ( this->*(OPTable[(opcode & 0xF000) >> 12]) )();
 
+#ifndef NO_TRACE
+    // record pc, opcode and register delta
+    if (tracer) tracer->Record(*this, pc_fetched);
+#else
+    (void)pc_fetched;
+#endif
+
     // run timer if set
     if (delay_timer > 0) delay_timer --;
     if (sound_timer > 0) sound_timer --;
 }
 
+// Decode ==> Execute a single opcode, pc must already point past it
+void Chip8::Execute(uint16_t op) {
+    opcode = op;
+    ( this->*(OPTable[(opcode & 0xF000) >> 12]) )();
+}
+
+// Reseed RNG (Cxkk) for reproducible runs
+void Chip8::Seed(uint32_t seed) {
+    rand_gen.seed(seed);
+}
+
+// Snapshot / rollback, a few plain memcpy()s
+void Chip8::SaveState(Chip8State &state) const {
+    memcpy(state.registers, registers, sizeof(registers));
+    memcpy(state.memory,    memory,    sizeof(memory));
+    memcpy(state.stack,     stack,     sizeof(stack));
+    memcpy(state.video,     video,     sizeof(video));
+    memcpy(state.rpl,       rpl,       sizeof(rpl));
+    state.hires       = hires;
+    state.index       = index;
+    state.pc          = pc;
+    state.sp          = sp;
+    state.delay_timer = delay_timer;
+    state.sound_timer = sound_timer;
+    state.opcode      = opcode;
+    state.rand_gen    = rand_gen;
+}
+
+void Chip8::LoadState(const Chip8State &state) {
+    memcpy(registers, state.registers, sizeof(registers));
+    memcpy(memory,    state.memory,    sizeof(memory));
+    memcpy(stack,     state.stack,     sizeof(stack));
+    memcpy(video,     state.video,     sizeof(video));
+    memcpy(rpl,       state.rpl,       sizeof(rpl));
+    hires       = state.hires;
+    index       = state.index;
+    pc          = state.pc;
+    sp          = state.sp;
+    delay_timer = state.delay_timer;
+    sound_timer = state.sound_timer;
+    opcode      = state.opcode;
+    rand_gen    = state.rand_gen;
+    memory_dirty = 0xFFFF;
+    video_dirty  = ~0ull;
+}
+
+// video ==> 1 bit per pixel, row-major, most significant bit = leftmost
+// pixel (VIDEO_PACKED_SIZE bytes)
+void Chip8::PackVideo(uint8_t* out) const {
+    for (int y = 0; y < VIDEO_HEIGHT; y ++) {
+        for (int byte = 0; byte < VIDEO_WIDTH / 8; byte ++) {
+            uint8_t bits = 0;
+            for (int bit = 0; bit < 8; bit ++) {
+                bits = (bits << 1) | (video[y][byte * 8 + bit] != 0);
+            }
+            *out ++ = bits;
+        }
+    }
+}
+
+// FNV-1a of `video`, as chip8_test and chip8_aot print it
+uint64_t Chip8::VideoHash() const {
+    return Fnv1a(video, sizeof(video));
+}
+
 // prepare OPTable
 void Chip8::Init_OPTable() {
     OPTable[0x0] = &Chip8::to_OPTable_0;
@@ -91,46 +238,52 @@ void Chip8::Init_OPTable() {
     OPTable[0x8] = &Chip8::to_OPTable_8;
     OPTable[0x9] = &Chip8::OP_9xy0;
     OPTable[0xA] = &Chip8::OP_Annn;
-    OPTable[0xB] = &Chip8::OP_Bnnn;
     OPTable[0xC] = &Chip8::OP_Cxkk;
-    OPTable[0xD] = &Chip8::OP_Dxyn;
     OPTable[0xE] = &Chip8::to_OPTable_E;
     OPTable[0xF] = &Chip8::to_OPTable_F;
 
-    for (int i = 0; i <= 0xE; i ++) OPTable_0[i] = &Chip8::OP_NULL;
-    OPTable_0[0x0] = &Chip8::OP_00E0;
-    OPTable_0[0xE] = &Chip8::OP_00EE;
-
-    for (int i = 0; i <= 0xE; i ++) OPTable_8[i] = &Chip8::OP_NULL;
+    for (int i = 0; i <= 0xFF; i ++) OPTable_0[i] = &Chip8::OP_NULL;
+    for (int i = 0xC0; i <= 0xCF; i ++) OPTable_0[i] = &Chip8::OP_00Cn;
+    OPTable_0[0xE0] = &Chip8::OP_00E0;
+    OPTable_0[0xEE] = &Chip8::OP_00EE;
+    OPTable_0[0xFB] = &Chip8::OP_00FB;
+    OPTable_0[0xFC] = &Chip8::OP_00FC;
+    OPTable_0[0xFD] = &Chip8::OP_00FD;
+    OPTable_0[0xFE] = &Chip8::OP_00FE;
+    OPTable_0[0xFF] = &Chip8::OP_00FF;
+
+    for (int i = 0; i <= 0xF; i ++) OPTable_8[i] = &Chip8::OP_NULL;
     OPTable_8[0x0] = &Chip8::OP_8xy0;
     OPTable_8[0x1] = &Chip8::OP_8xy1;
     OPTable_8[0x2] = &Chip8::OP_8xy2;
     OPTable_8[0x3] = &Chip8::OP_8xy3;
     OPTable_8[0x4] = &Chip8::OP_8xy4;
     OPTable_8[0x5] = &Chip8::OP_8xy5;
-    OPTable_8[0x6] = &Chip8::OP_8xy6;
     OPTable_8[0x7] = &Chip8::OP_8xy7;
-    OPTable_8[0xE] = &Chip8::OP_8xyE;
 
-    for (int i = 0; i <= 0xA1; i ++) OPTable_E[i] = &Chip8::OP_NULL;
+    for (int i = 0; i <= 0xFF; i ++) OPTable_E[i] = &Chip8::OP_NULL;
     OPTable_E[0x9E] = &Chip8::OP_Ex9E;
     OPTable_E[0xA1] = &Chip8::OP_ExA1;
 
-    for (int i = 0; i <= 0x65; i ++) OPTable_F[i] = &Chip8::OP_NULL;
+    for (int i = 0; i <= 0xFF; i ++) OPTable_F[i] = &Chip8::OP_NULL;
     OPTable_F[0x07] = &Chip8::OP_Fx07;
     OPTable_F[0x0A] = &Chip8::OP_Fx0A;
     OPTable_F[0x15] = &Chip8::OP_Fx15;
     OPTable_F[0x18] = &Chip8::OP_Fx18;
     OPTable_F[0x1E] = &Chip8::OP_Fx1E;
     OPTable_F[0x29] = &Chip8::OP_Fx29;
+    OPTable_F[0x30] = &Chip8::OP_Fx30;
     OPTable_F[0x33] = &Chip8::OP_Fx33;
-    OPTable_F[0x55] = &Chip8::OP_Fx55;
-    OPTable_F[0x65] = &Chip8::OP_Fx65;
+    OPTable_F[0x75] = &Chip8::OP_Fx75;
+    OPTable_F[0x85] = &Chip8::OP_Fx85;
+
+    // 8xy6, 8xyE, Bnnn, Dxyn, Fx55, Fx65
+    Use_Quirks<QUIRKS_DEFAULT>();
 }
 
 // sub-OPTable
 void Chip8::to_OPTable_0() {
-    (this->*OPTable_0[opcode & 0x000F])();
+    (this->*OPTable_0[opcode & 0x00FF])();
 }
 void Chip8::to_OPTable_8() {
     (this->*OPTable_8[opcode & 0x000F])();
@@ -145,17 +298,64 @@ void Chip8::to_OPTable_F() {
 void Chip8::OP_NULL() {}
 
 // ******  opcode implement  ******
+// scroll the display down n pixels (SUPER-CHIP)
+// whole rows move at once; in lo-res a pixel is 2 rows high
+void Chip8::OP_00Cn() {
+    uint8_t rows = (opcode & 0x000F) * (hires ? 1 : 2);
+    memmove(video[rows], video[0], (VIDEO_HEIGHT - rows) * sizeof(video[0]));
+    memset(video[0], 0, rows * sizeof(video[0]));
+    video_dirty |= video_dirty << rows;
+}
+
 // clear the display
 void Chip8::OP_00E0() {
     memset(video, 0, sizeof(video));
+    video_dirty = 0;
 }
 
 // return from a subroutine
 void Chip8::OP_00EE() {
-    sp --;
+    sp = (sp - 1) & 0xF; // the stack wraps instead of running off
     pc = stack[sp];
 }
 
+// scroll the display right 4 pixels (SUPER-CHIP)
+void Chip8::OP_00FB() {
+    uint8_t shift = hires ? 4 : 8;
+    for (auto &line : video) {
+        memmove(line + shift, line, (VIDEO_WIDTH - shift) * sizeof(line[0]));
+        memset(line, 0, shift * sizeof(line[0]));
+    }
+}
+
+// scroll the display left 4 pixels (SUPER-CHIP)
+void Chip8::OP_00FC() {
+    uint8_t shift = hires ? 4 : 8;
+    for (auto &line : video) {
+        memmove(line, line + shift, (VIDEO_WIDTH - shift) * sizeof(line[0]));
+        memset(line + VIDEO_WIDTH - shift, 0, shift * sizeof(line[0]));
+    }
+}
+
+// exit the interpreter: stay on this instruction (SUPER-CHIP)
+void Chip8::OP_00FD() {
+    pc -= 2;
+}
+
+// lo-res (64x32) mode, clears the display (SUPER-CHIP)
+void Chip8::OP_00FE() {
+    hires = false;
+    memset(video, 0, sizeof(video));
+    video_dirty = 0;
+}
+
+// hi-res (128x64) mode, clears the display (SUPER-CHIP)
+void Chip8::OP_00FF() {
+    hires = true;
+    memset(video, 0, sizeof(video));
+    video_dirty = 0;
+}
+
 // jump to location nnn
 void Chip8::OP_1nnn() {
     uint16_t address = opcode & 0x0FFF;
@@ -166,7 +366,7 @@ void Chip8::OP_1nnn() {
 void Chip8::OP_2nnn() {
     uint16_t address = opcode & 0x0FFF;
     stack[sp] = pc;
-    sp ++;
+    sp = (sp + 1) & 0xF;
     pc = address;
 }
 
@@ -264,10 +464,14 @@ void Chip8::OP_8xy5() {
 }
 
 // set Vx = Vx >> 1, set VF = the shifted out bit
+// (Q::shift_vy: Vx = Vy >> 1)
+template <class Q>
 void Chip8::OP_8xy6() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
-    registers[VF] = registers[Vx] & 0x0001;
-    registers[Vx] >>= 1;
+    uint8_t Vy = (opcode & 0x00F0) >> 4;
+    uint8_t value = registers[Q::shift_vy ? Vy : Vx];
+    registers[VF] = value & 0x01;
+    registers[Vx] = value >> 1;
 }
 
 // set Vx = Vy - Vx, set VF = NOT borrow
@@ -283,10 +487,14 @@ void Chip8::OP_8xy7() {
 }
 
 // set Vx = Vx << 1, set VF = the shifted out bit
+// (Q::shift_vy: Vx = Vy << 1)
+template <class Q>
 void Chip8::OP_8xyE() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
-    registers[VF] = registers[Vx] & 0x8000;
-    registers[Vx] <<= 1;
+    uint8_t Vy = (opcode & 0x00F0) >> 4;
+    uint8_t value = registers[Q::shift_vy ? Vy : Vx];
+    registers[VF] = (value & 0x80) >> 7;
+    registers[Vx] = value << 1;
 }
 
 // skip next instruction if Vx != Vy
@@ -305,9 +513,12 @@ void Chip8::OP_Annn() {
 }
 
 // jump to location V0 + nnn
+// (Q::jump_vx: Vx + xnn)
+template <class Q>
 void Chip8::OP_Bnnn() {
     uint16_t address = opcode & 0x0FFF;
-    pc = registers[V0] + address;
+    uint8_t  Vx = (opcode & 0x0F00) >> 8;
+    pc = registers[Q::jump_vx ? Vx : V0] + address;
 }
 
 // set Vx = random byte AND kk
@@ -318,6 +529,7 @@ void Chip8::OP_Cxkk() {
 }
 
 // display n-byte sprite starting at index at (Vx, Vy), set VF = collision
+// (Dxy0: 16x16 sprite, 2 bytes per row)
 // "sprite pixel" = pixel to be plotted
 // +--------------> x    i.e. 'F' in memory:
 // |  (Vx,Vy)               index --> 0xF0
@@ -326,27 +538,46 @@ void Chip8::OP_Cxkk() {
 // |    |n        |                   0x80
 // |    |         |                   0x80
 // v y  +---------+
+// (Q::wrap: pixels past the edge wrap around instead of being clipped)
+template <class Q>
 void Chip8::OP_Dxyn() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
     uint8_t Vy = (opcode & 0x00F0) >> 4;
     uint8_t height = opcode & 0x000F;
+    uint8_t width  = 8;
+    if (height == 0) height = width = 16;
+
+    // coordinates are in the current mode's pixels; a lo-res pixel
+    // covers scale x scale pixels of video
+    uint8_t scale  = hires ? 1 : 2;
+    uint8_t cols   = VIDEO_WIDTH  / scale;
+    uint8_t rows   = VIDEO_HEIGHT / scale;
 
     // wrap if out of display
-    uint8_t x_pox = registers[Vx] % VIDEO_WIDTH;
-    uint8_t y_pox = registers[Vy] % VIDEO_HEIGHT;
+    uint8_t x_pox = registers[Vx] % cols;
+    uint8_t y_pox = registers[Vy] % rows;
 
     registers[VF] = 0;
     for (uint8_t row = 0; row < height; row ++) {
-        uint8_t sprite_byte = memory[index + row];
+        // sprite row, leftmost pixel in bit 15
+        uint16_t sprite_bits = memory[(index + row * (width / 8)) & 0x0FFF] << 8;
+        if (width == 16) sprite_bits |= memory[(index + row * 2 + 1) & 0x0FFF];
+
+        for (uint8_t col = 0; col < width; col ++) {
+            uint8_t x = x_pox + col;
+            uint8_t y = y_pox + row;
+            if constexpr (Q::wrap) {
+                x %= cols;
+                y %= rows;
+            }
 
-        for (uint8_t col = 0; col < 8; col ++) {
-            // check if the pixel is within bounds
-            if (y_pox + row < VIDEO_HEIGHT && x_pox + col < VIDEO_WIDTH) {
-                uint8_t sprite_pixel = sprite_byte & (0x80 >> col);       // get current pixel to be plotted
-                uint32_t *screen_pixel = &video[y_pox + row][x_pox + col]; // get current pixel on screen
+            // check if the pixel is within bounds, and sprite_pixel is ON
+            if (y >= rows || x >= cols || !(sprite_bits & (0x8000 >> col))) continue;
+            video_dirty |= ((1ull << scale) - 1) << (y * scale);
 
-                // sprite_pixel is ON
-                if (sprite_pixel) {
+            for (uint8_t dy = 0; dy < scale; dy ++) {
+                uint32_t *screen_pixel = &video[y * scale + dy][x * scale]; // get current pixel on screen
+                for (uint8_t dx = 0; dx < scale; dx ++, screen_pixel ++) {
                     // screen_pixel is ON
                     if (*screen_pixel == 0xFFFFFFFF) {
                         registers[VF] = 1; // set collision flag
@@ -361,7 +592,7 @@ void Chip8::OP_Dxyn() {
 // skip next instruction if key [Vx] is pressed
 void Chip8::OP_Ex9E() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
-    uint8_t key = registers[Vx];
+    uint8_t key = registers[Vx] & 0xF;
     if (keypad[key]) {
         pc += 2;
     }
@@ -370,7 +601,7 @@ void Chip8::OP_Ex9E() {
 // skip next instruction if key [Vx] is NOT pressed
 void Chip8::OP_ExA1() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
-    uint8_t key = registers[Vx];
+    uint8_t key = registers[Vx] & 0xF;
     if (!keypad[key]) {
         pc += 2;
     }
@@ -386,13 +617,13 @@ void Chip8::OP_Fx07() {
 void Chip8::OP_Fx0A() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
     uint8_t key_num = 0;
-    for (; key_num < 0xF; key_num ++) {
+    for (; key_num <= 0xF; key_num ++) {
         if (keypad[key_num]) {
             registers[Vx] = key_num;
             break;
         }
     }
-    if (key_num == 0xF) pc -= 2; // repeat this instruction
+    if (key_num > 0xF) pc -= 2; // repeat this instruction
 }
 
 // set delay_timer = Vx
@@ -421,31 +652,60 @@ void Chip8::OP_Fx29() {
     index = FONTSET_START_ADDRESS + (5 * digit);
 }
 
+// set index = location of the big (8x10) sprite of digit Vx (SUPER-CHIP)
+void Chip8::OP_Fx30() {
+    uint8_t Vx = (opcode & 0x0F00) >> 8;
+    uint8_t digit = registers[Vx] & 0xF;
+    index = BIGFONT_START_ADDRESS + (10 * digit);
+}
+
 // store BCD of Vx in {index, index + 1, index + 2}
 // ==> {Hundreds, Tens, Ones}
 void Chip8::OP_Fx33() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
     uint8_t value = registers[Vx];
-    memory[index + 2] = value % 10;
+    Touch(index, 3);
+    // addresses wrap at the end of memory, as in Dxyn/Fx55/Fx65
+    memory[(index + 2) & 0x0FFF] = value % 10;
     value /= 10;
-    memory[index + 1] = value % 10;
+    memory[(index + 1) & 0x0FFF] = value % 10;
     value /= 10;
-    memory[index] = value % 10;
+    memory[index & 0x0FFF] = value % 10;
 }
 
 // store V0-Vx starting at [index]
+// (Q::index_moves: then index = index + x + 1)
+template <class Q>
 void Chip8::OP_Fx55() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
+    Touch(index, Vx + 1);
     for (uint8_t i = 0; i <= Vx; i ++) {
-        memory[index + i] = registers[i];
+        memory[(index + i) & 0x0FFF] = registers[i];
     }
+    if constexpr (Q::index_moves) index += Vx + 1;
 }
 
 // set V0-Vx = [index]...[index + x]
+// (Q::index_moves: then index = index + x + 1)
+template <class Q>
 void Chip8::OP_Fx65() {
     uint8_t Vx = (opcode & 0x0F00) >> 8;
     for (uint8_t i = 0; i <= Vx; i ++) {
-        registers[i] = memory[index + i];
+        registers[i] = memory[(index + i) & 0x0FFF];
     }
+    if constexpr (Q::index_moves) index += Vx + 1;
+}
+
+// store V0-Vx in the RPL user flags (SUPER-CHIP)
+// (the HP-48 had 8 of them; XO-CHIP allows all 16)
+void Chip8::OP_Fx75() {
+    uint8_t Vx = (opcode & 0x0F00) >> 8;
+    memcpy(rpl, registers, Vx + 1);
+}
+
+// set V0-Vx = RPL user flags (SUPER-CHIP)
+void Chip8::OP_Fx85() {
+    uint8_t Vx = (opcode & 0x0F00) >> 8;
+    memcpy(registers, rpl, Vx + 1);
 }
 // ******  end of: opcode implement  ******
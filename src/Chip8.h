@@ -1,6 +1,9 @@
 #ifndef __CHIP8_H__
 #define __CHIP8_H__
 
+#include "Quirks.h"
+
+#include <cstddef>
 #include <cstdint>
 #include <random>
 #include <string>
@@ -8,18 +11,59 @@
 const uint16_t START_ADDRESS         = 0x200;
 const uint16_t FONTSET_START_ADDRESS = 0x50;
 const uint16_t FONTSET_SIZE          = 80;
-const uint8_t  VIDEO_WIDTH           = 64;
-const uint8_t  VIDEO_HEIGHT          = 32;
+const uint16_t BIGFONT_START_ADDRESS = 0xA0; // SUPER-CHIP 8x10 digits, right after the small ones
+const uint16_t BIGFONT_SIZE          = 160;
+const uint8_t  VIDEO_WIDTH           = 128;  // SUPER-CHIP hi-res; in lo-res (64x32)
+const uint8_t  VIDEO_HEIGHT          = 64;   // every pixel is drawn as a 2x2 block
+const uint16_t VIDEO_PACKED_SIZE     = VIDEO_WIDTH * VIDEO_HEIGHT / 8; // PackVideo()
+
+class TraceWriter;
 
+// Everything a running ROM can observe (keypad is input, not state)
+struct Chip8State {
+    uint8_t   registers   [16];
+    uint8_t   memory      [4096];
+    uint16_t  index;
+    uint16_t  pc;
+    uint16_t  stack       [16];
+    uint8_t   sp;
+    uint8_t   delay_timer;
+    uint8_t   sound_timer;
+    uint32_t  opcode;
+    uint32_t  video   [VIDEO_HEIGHT]
+                      [VIDEO_WIDTH ];
+    bool      hires;
+    uint8_t   rpl         [16];
+    std::default_random_engine rand_gen;
+};
 
 class Chip8 {
   public:
     // Chip initialization
     Chip8();
+    // Back to power-on state in place (RNG and tracer are kept); clears only
+    // the memory pages and video rows the core wrote since the last Reset()
+    void Reset();
     // Load ROM from file
     void LoadROM(const std::string filename, bool &success);
+    // Load ROM from buffer
+    void LoadROM(const uint8_t* data, size_t size, bool &success);
+    // Switch the quirk-dependent opcode handlers (no cost per instruction)
+    void SetQuirks(Quirks profile);
     // Fetch ==> Decode ==> Execute
     void Cycle(bool &success);
+    // Decode ==> Execute a single opcode, pc must already point past it
+    void Execute(uint16_t op);
+    // Reseed RNG (Cxkk) for reproducible runs
+    void Seed(uint32_t seed);
+    // Snapshot / rollback, a few plain memcpy()s
+    void SaveState(Chip8State &state) const;
+    void LoadState(const Chip8State &state);
+    // video ==> 1 bit per pixel, row-major, most significant bit = leftmost
+    // pixel (VIDEO_PACKED_SIZE bytes)
+    void PackVideo(uint8_t* out) const;
+    // FNV-1a of `video`, as chip8_test and chip8_aot print it
+    uint64_t VideoHash() const;
 
     uint8_t   registers   [16]       = {};
     uint8_t   memory      [4096]     = {};
@@ -33,14 +77,22 @@ class Chip8 {
     uint8_t   keypad      [16]       = {};
     uint32_t  video   [VIDEO_HEIGHT]       // all pixels on display
                       [VIDEO_WIDTH ] = {}; // video[y][x], each pixel: full 0/F
+    bool      hires                  = false; // 128x64 mode (00FF), else 64x32 (00FE)
+    uint8_t   rpl         [16]       = {}; // SUPER-CHIP "RPL user flags" (Fx75/Fx85)
+
+    Quirks    quirks                 = QUIRKS_DEFAULT;
+    TraceWriter* tracer              = nullptr; // record every Cycle() if set (ignored with -D NO_TRACE)
 
   private:
     typedef void (Chip8::*OP)(void);
     OP        OPTable     [0xF  + 1] = {}; // 0x0 ~ 0xF
-    OP        OPTable_0   [0xE  + 1] = {}; // 0x0 ~ 0xE
-    OP        OPTable_8   [0xE  + 1] = {}; // 0x0 ~ 0xE
-    OP        OPTable_E   [0xA1 + 1] = {}; // 0x0 ~ 0xA1
-    OP        OPTable_F   [0x65 + 1] = {}; // 0x0 ~ 0x55
+    OP        OPTable_0   [0xFF + 1] = {}; // 0x0 ~ 0xFF
+    OP        OPTable_8   [0xF  + 1] = {}; // 0x0 ~ 0xF
+    OP        OPTable_E   [0xFF + 1] = {}; // 0x0 ~ 0xFF, so any opcode decodes
+    OP        OPTable_F   [0xFF + 1] = {}; // 0x0 ~ 0xFF
+
+    uint16_t  memory_dirty = 0xFFFF; // bit p: memory page p (256 bytes) written since Reset()
+    uint64_t  video_dirty  = ~0ull;  // bit y: video row y may have lit pixels
 
     std::default_random_engine             rand_gen;
     std::uniform_int_distribution<uint8_t> rand_byte;
@@ -71,21 +123,57 @@ class Chip8 {
         0xF0, 0x80, 0xF0, 0x80, 0x80  // F
     };
 
-    // prepare OPTable
+    // SUPER-CHIP 8x10 digits (Fx30)
+    uint8_t bigfont[BIGFONT_SIZE] = {
+        0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+        0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+        0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+        0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+        0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+        0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+        0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+        0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+    };
+
+    // prepare OPTable, once per instance
     void Init_OPTable();
+    // note the memory pages a store of `length` bytes at `at` reaches
+    void Touch(uint16_t at, uint16_t length);
     // sub-OPTable
     void to_OPTable_0();
     void to_OPTable_8();
     void to_OPTable_E();
     void to_OPTable_F();
+    // point the quirk-dependent OPTable entries at profile P's handlers
+    template <Quirks P> void Use_Quirks();
     // NULL opcode
     void OP_NULL();
 
     // ******  opcode implement  ******
+    // scroll the display down n pixels (SUPER-CHIP)
+    void OP_00Cn();
     // clear the display
     void OP_00E0();
     // return from a subroutine
     void OP_00EE();
+    // scroll the display right 4 pixels (SUPER-CHIP)
+    void OP_00FB();
+    // scroll the display left 4 pixels (SUPER-CHIP)
+    void OP_00FC();
+    // exit the interpreter: stay on this instruction (SUPER-CHIP)
+    void OP_00FD();
+    // lo-res (64x32) mode, clears the display (SUPER-CHIP)
+    void OP_00FE();
+    // hi-res (128x64) mode, clears the display (SUPER-CHIP)
+    void OP_00FF();
     // jump to location nnn
     void OP_1nnn();
     // call subroutine at nnn
@@ -114,21 +202,25 @@ class Chip8 {
     // Vx > Vy ==> VF = 1
     void OP_8xy5();
     // set Vx = Vx >> 1, set VF = the shifted out bit
-    void OP_8xy6();
+    // (Q::shift_vy: Vx = Vy >> 1)
+    template <class Q> void OP_8xy6();
     // set Vx = Vy - Vx, set VF = NOT borrow
     // Vy > Vx ==> VF = 1
     void OP_8xy7();
     // set Vx = Vx << 1, set VF = the shifted out bit
-    void OP_8xyE();
+    // (Q::shift_vy: Vx = Vy << 1)
+    template <class Q> void OP_8xyE();
     // skip next instruction if Vx != Vy
     void OP_9xy0();
     // set index (of memory) = nnn
     void OP_Annn();
     // jump to location V0 + nnn
-    void OP_Bnnn();
+    // (Q::jump_vx: Vx + xnn)
+    template <class Q> void OP_Bnnn();
     // set Vx = random byte AND kk
     void OP_Cxkk();
     // display n-byte sprite starting at index at (Vx, Vy), set VF = collision
+    // (Dxy0: 16x16 sprite, 2 bytes per row)
     // "sprite pixel" = pixel to be plotted
 	// +--------------> x    i.e. 'F' in memory:
 	// |  (Vx,Vy)               index --> 0xF0
@@ -137,7 +229,8 @@ class Chip8 {
 	// |    |n        |                   0x80
 	// |    |         |                   0x80
 	// v y  +---------+
-    void OP_Dxyn();
+    // (Q::wrap: pixels past the edge wrap around instead of being clipped)
+    template <class Q> void OP_Dxyn();
     // skip next instruction if key [Vx] is pressed
     void OP_Ex9E();
     // skip next instruction if key [Vx] is NOT pressed
@@ -155,13 +248,21 @@ class Chip8 {
     // set index = location of the sprite of digit Vx
     // i.e. Vx = 5, index --> "5"
     void OP_Fx29();
+    // set index = location of the big (8x10) sprite of digit Vx (SUPER-CHIP)
+    void OP_Fx30();
     // store BCD of Vx in {index, index + 1, index + 2}
     // ==> {Hundreds, Tens, Ones}
     void OP_Fx33();
     // store V0-Vx starting at [index]
-    void OP_Fx55();
+    // (Q::index_moves: then index = index + x + 1)
+    template <class Q> void OP_Fx55();
     // set V0-Vx = [index]...[index + x]
-    void OP_Fx65();
+    // (Q::index_moves: then index = index + x + 1)
+    template <class Q> void OP_Fx65();
+    // store V0-Vx in the RPL user flags (SUPER-CHIP)
+    void OP_Fx75();
+    // set V0-Vx = RPL user flags (SUPER-CHIP)
+    void OP_Fx85();
     // ******  end of: opcode implement  ******
 };
 
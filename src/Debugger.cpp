@@ -0,0 +1,244 @@
+#include "Debugger.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#define ACCESS_READ  1
+#define ACCESS_WRITE 2
+
+
+// whole string as hex, at most `max`
+static bool ParseHex(const std::string text, unsigned max, unsigned &value) {
+    size_t used = 0;
+    try {
+        value = std::stoul(text, &used, 16);
+    } catch (std::logic_error const& ex) {
+        return false;
+    }
+    return used == text.size() && value <= max;
+}
+
+// "V3==1F"
+static bool ParseCondition(const std::string text, Condition &condition) {
+    const char* ops[] = { "==", "!=", "<=", ">=", "<", ">" };
+    const Compare compares[] = { CMP_EQ, CMP_NE, CMP_LE, CMP_GE, CMP_LT, CMP_GT };
+
+    unsigned reg, value;
+    if (text.size() < 4 || (text[0] != 'V' && text[0] != 'v')) return false;
+    if (!ParseHex(text.substr(1, 1), 0xF, reg)) return false;
+
+    for (int i = 0; i < 6; i ++) {
+        std::string op = ops[i];
+        if (text.compare(2, op.size(), op) == 0) {
+            if (!ParseHex(text.substr(2 + op.size()), 0xFF, value)) return false;
+            condition.reg     = reg;
+            condition.compare = compares[i];
+            condition.value   = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "2A0", "2A0,V3==1F", "V3>=10"
+void Debugger::AddBreakpoint(const std::string spec, bool &success) {
+    unsigned pc;
+    size_t comma = spec.find(',');
+    Condition condition;
+
+    if (comma != std::string::npos) {
+        if (!ParseHex(spec.substr(0, comma), 0xFFF, pc)
+                || !ParseCondition(spec.substr(comma + 1), condition)) {
+            success = false;
+            return;
+        }
+        condition.pc = pc;
+        conditions.push_back(condition);
+    } else if (ParseHex(spec, 0xFFF, pc)) {
+        pc_breaks[pc] = true;
+    } else if (ParseCondition(spec, condition)) {
+        conditions.push_back(condition);
+    } else {
+        success = false;
+        return;
+    }
+    Rearm();
+}
+
+// "300-30F" or "300", optionally ":r" / ":w" (default both)
+void Debugger::AddWatchpoint(const std::string spec, bool &success) {
+    std::string range = spec;
+    int access = ACCESS_READ | ACCESS_WRITE;
+    size_t colon = spec.find(':');
+    if (colon != std::string::npos) {
+        std::string mode = spec.substr(colon + 1);
+        range = spec.substr(0, colon);
+        if      (mode == "r")  access = ACCESS_READ;
+        else if (mode == "w")  access = ACCESS_WRITE;
+        else if (mode != "rw") success = false;
+    }
+
+    unsigned first = 0, last = 0;
+    size_t dash = range.find('-');
+    if (dash == std::string::npos) {
+        if (!ParseHex(range, 0xFFF, first)) success = false;
+        last = first;
+    } else if (!ParseHex(range.substr(0, dash), 0xFFF, first)
+            || !ParseHex(range.substr(dash + 1), 0xFFF, last) || last < first) {
+        success = false;
+    }
+    if (!success) return;
+
+    for (unsigned address = first; address <= last; address ++) {
+        if (access & ACCESS_READ)  read_watch[address]  = true;
+        if (access & ACCESS_WRITE) write_watch[address] = true;
+    }
+    Rearm();
+}
+
+void Debugger::ToggleBreakpoint(uint16_t pc) {
+    pc_breaks.flip(pc & 0x0FFF);
+    Rearm();
+}
+
+void Debugger::Rearm() {
+    armed = pc_breaks.any() || read_watch.any() || write_watch.any() || !conditions.empty();
+}
+
+// checks, then Chip8::Cycle(); return false (nothing run, paused) on a hit
+bool Debugger::Cycle(Chip8 &chip8, bool &success) {
+    if (Hit(chip8)) {
+        paused = true;
+        return false;
+    }
+    chip8.Cycle(success);
+    return true;
+}
+
+// run the instruction at pc without checks, to resume or single-step
+void Debugger::Step(Chip8 &chip8, bool &success) {
+    chip8.Cycle(success);
+}
+
+// does the instruction at pc hit anything? sets `reason`
+bool Debugger::Hit(const Chip8 &chip8) {
+    char text[64];
+    uint16_t pc = chip8.pc & 0x0FFF;
+
+    if (pc_breaks[pc]) {
+        snprintf(text, sizeof(text), "breakpoint at %03X", pc);
+        reason = text;
+        return true;
+    }
+
+    for (const Condition &condition : conditions) {
+        if (condition.pc >= 0 && condition.pc != pc) continue;
+        uint8_t value = chip8.registers[condition.reg];
+        bool hit = false;
+        switch (condition.compare) {
+            case CMP_EQ: hit = (value == condition.value); break;
+            case CMP_NE: hit = (value != condition.value); break;
+            case CMP_LT: hit = (value <  condition.value); break;
+            case CMP_GT: hit = (value >  condition.value); break;
+            case CMP_LE: hit = (value <= condition.value); break;
+            case CMP_GE: hit = (value >= condition.value); break;
+        }
+        if (hit) {
+            snprintf(text, sizeof(text), "V%X = %02X at %03X", condition.reg, value, pc);
+            reason = text;
+            return true;
+        }
+    }
+
+    // decode which memory the instruction is about to touch
+    if (pc + 1 >= 4096) return false;
+    uint16_t op = (chip8.memory[pc] << 8) | chip8.memory[pc + 1];
+    uint8_t  x  = (op & 0x0F00) >> 8;
+    int length = 0;
+    int access = 0;
+    if      ((op & 0xF00F) == 0xD000) { length = 32;          access = ACCESS_READ;  } // 16x16
+    else if ((op & 0xF000) == 0xD000) { length = op & 0x000F; access = ACCESS_READ;  }
+    else if ((op & 0xF0FF) == 0xF033) { length = 3;           access = ACCESS_WRITE; }
+    else if ((op & 0xF0FF) == 0xF055) { length = x + 1;       access = ACCESS_WRITE; }
+    else if ((op & 0xF0FF) == 0xF065) { length = x + 1;       access = ACCESS_READ;  }
+
+    const std::bitset<4096> &watch = (access == ACCESS_READ) ? read_watch : write_watch;
+    for (int i = 0; i < length; i ++) {
+        uint16_t address = (chip8.index + i) & 0x0FFF; // wraps like the core does
+        if (watch[address]) {
+            snprintf(text, sizeof(text), "%s %03X at %03X",
+                     (access == ACCESS_READ) ? "read" : "write", address, pc);
+            reason = text;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "DRW V1, V2, 5" style mnemonic of an opcode, as `quirks` executes it
+std::string Disassemble(uint16_t opcode, Quirks quirks) {
+    char text[32];
+    unsigned x   = (opcode & 0x0F00) >> 8;
+    unsigned y   = (opcode & 0x00F0) >> 4;
+    unsigned n   =  opcode & 0x000F;
+    unsigned kk  =  opcode & 0x00FF;
+    unsigned nnn =  opcode & 0x0FFF;
+
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            if      (opcode == 0x00E0) snprintf(text, sizeof(text), "CLS");
+            else if (opcode == 0x00EE) snprintf(text, sizeof(text), "RET");
+            else if ((opcode & 0xFFF0) == 0x00C0) snprintf(text, sizeof(text), "SCD %X", n);
+            else if (opcode == 0x00FB) snprintf(text, sizeof(text), "SCR");
+            else if (opcode == 0x00FC) snprintf(text, sizeof(text), "SCL");
+            else if (opcode == 0x00FD) snprintf(text, sizeof(text), "EXIT");
+            else if (opcode == 0x00FE) snprintf(text, sizeof(text), "LOW");
+            else if (opcode == 0x00FF) snprintf(text, sizeof(text), "HIGH");
+            else                       snprintf(text, sizeof(text), "SYS %03X", nnn);
+            break;
+        case 0x1000: snprintf(text, sizeof(text), "JP %03X", nnn);                 break;
+        case 0x2000: snprintf(text, sizeof(text), "CALL %03X", nnn);               break;
+        case 0x3000: snprintf(text, sizeof(text), "SE V%X, %02X", x, kk);          break;
+        case 0x4000: snprintf(text, sizeof(text), "SNE V%X, %02X", x, kk);         break;
+        case 0x5000: snprintf(text, sizeof(text), "SE V%X, V%X", x, y);            break;
+        case 0x6000: snprintf(text, sizeof(text), "LD V%X, %02X", x, kk);          break;
+        case 0x7000: snprintf(text, sizeof(text), "ADD V%X, %02X", x, kk);         break;
+        case 0x8000: {
+            const char* names[16] = { "LD", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN",
+                                      nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "SHL", nullptr };
+            if (names[n]) snprintf(text, sizeof(text), "%s V%X, V%X", names[n], x, y);
+            else          snprintf(text, sizeof(text), "DW %04X", opcode);
+            break;
+        }
+        case 0x9000: snprintf(text, sizeof(text), "SNE V%X, V%X", x, y);           break;
+        case 0xA000: snprintf(text, sizeof(text), "LD I, %03X", nnn);              break;
+        case 0xB000: snprintf(text, sizeof(text), "JP V%X, %03X", QUIRKS[quirks].jump_vx ? x : 0, nnn); break;
+        case 0xC000: snprintf(text, sizeof(text), "RND V%X, %02X", x, kk);         break;
+        case 0xD000: snprintf(text, sizeof(text), "DRW V%X, V%X, %X", x, y, n);    break;
+        case 0xE000:
+            if      (kk == 0x9E) snprintf(text, sizeof(text), "SKP V%X", x);
+            else if (kk == 0xA1) snprintf(text, sizeof(text), "SKNP V%X", x);
+            else                 snprintf(text, sizeof(text), "DW %04X", opcode);
+            break;
+        case 0xF000:
+            switch (kk) {
+                case 0x07: snprintf(text, sizeof(text), "LD V%X, DT", x);          break;
+                case 0x0A: snprintf(text, sizeof(text), "LD V%X, K", x);           break;
+                case 0x15: snprintf(text, sizeof(text), "LD DT, V%X", x);          break;
+                case 0x18: snprintf(text, sizeof(text), "LD ST, V%X", x);          break;
+                case 0x1E: snprintf(text, sizeof(text), "ADD I, V%X", x);          break;
+                case 0x29: snprintf(text, sizeof(text), "LD F, V%X", x);           break;
+                case 0x30: snprintf(text, sizeof(text), "LD HF, V%X", x);          break;
+                case 0x33: snprintf(text, sizeof(text), "LD B, V%X", x);           break;
+                case 0x55: snprintf(text, sizeof(text), "LD [I], V%X", x);         break;
+                case 0x65: snprintf(text, sizeof(text), "LD V%X, [I]", x);         break;
+                case 0x75: snprintf(text, sizeof(text), "LD R, V%X", x);           break;
+                case 0x85: snprintf(text, sizeof(text), "LD V%X, R", x);           break;
+                default:   snprintf(text, sizeof(text), "DW %04X", opcode);        break;
+            }
+            break;
+    }
+    return text;
+}
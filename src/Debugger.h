@@ -0,0 +1,62 @@
+#ifndef __DEBUGGER_H__
+#define __DEBUGGER_H__
+
+#include "Chip8.h"
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum Compare { CMP_EQ, CMP_NE, CMP_LT, CMP_GT, CMP_LE, CMP_GE };
+
+// break when `reg` compares true against `value`, at `pc` or anywhere (-1)
+struct Condition {
+    int      pc      = -1;
+    uint8_t  reg     = 0;
+    Compare  compare = CMP_EQ;
+    uint8_t  value   = 0;
+};
+
+// Breakpoints and memory watchpoints, all checked *before* an instruction
+// runs, so a hit leaves the machine on the instruction that triggered it.
+//
+// Chip8::Cycle() knows nothing about this: the front end calls
+// Debugger::Cycle() instead only while something is Armed(), so a run
+// without breakpoints executes the plain core.
+class Debugger {
+  public:
+    // "2A0" (pc), "2A0,V3==1F" (pc and register), "V3>=10" (register, any pc);
+    // numbers in hex, compare with == != < > <= >=
+    void AddBreakpoint(const std::string spec, bool &success);
+    // "300-30F" or "300", optionally ":r" / ":w" (default both)
+    void AddWatchpoint(const std::string spec, bool &success);
+    void ToggleBreakpoint(uint16_t pc);
+    bool IsBreakpoint(uint16_t pc) const { return pc_breaks[pc & 0x0FFF]; }
+
+    // anything to check? if not, call Chip8::Cycle() directly
+    bool Armed() const { return armed; }
+    // checks, then Chip8::Cycle(); return false (nothing run, paused) on a hit
+    bool Cycle(Chip8 &chip8, bool &success);
+    // run the instruction at pc without checks, to resume or single-step
+    void Step(Chip8 &chip8, bool &success);
+
+    bool        paused = false;
+    std::string reason;          // why it stopped, for the debug pane
+
+  private:
+    std::bitset<4096>      pc_breaks;
+    std::bitset<4096>      read_watch;
+    std::bitset<4096>      write_watch;
+    std::vector<Condition> conditions;
+    bool                   armed = false;
+
+    void Rearm();
+    // does the instruction at pc hit anything? sets `reason`
+    bool Hit(const Chip8 &chip8);
+};
+
+// "DRW V1, V2, 5" style mnemonic of an opcode, as `quirks` executes it
+std::string Disassemble(uint16_t opcode, Quirks quirks);
+
+#endif // __DEBUGGER_H__
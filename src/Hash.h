@@ -0,0 +1,18 @@
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <cstddef>
+#include <cstdint>
+
+const uint64_t FNV1A_OFFSET = 0xCBF29CE484222325;
+const uint64_t FNV1A_PRIME  = 0x100000001B3;
+
+// 64-bit FNV-1a of `size` bytes; pass the previous result as `hash` to
+// hash several buffers as one
+inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = FNV1A_OFFSET) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i ++) hash = (hash ^ bytes[i]) * FNV1A_PRIME;
+    return hash;
+}
+
+#endif // __HASH_H__
@@ -0,0 +1,235 @@
+#include "Input.h"
+
+#include <cctype>  // tolower()
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib> // atoi()
+#include <cstring> // strchr()
+#include <fcntl.h>
+#include <linux/input.h>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define ESC_TIMEOUT 25 // ms a lone ESC waits for the rest of a sequence
+
+// keyboard layout of the keypad, i.e. KEYPAD_KEYS[0x5] = 'w' (see README)
+static const char KEYPAD_KEYS[] = "x123qweasdzc4rfv";
+
+// evdev key codes of the same layout
+static const uint16_t EVDEV_KEYS[16] = {
+    KEY_X, KEY_1, KEY_2, KEY_3,
+    KEY_Q, KEY_W, KEY_E, KEY_A,
+    KEY_S, KEY_D, KEY_Z, KEY_C,
+    KEY_4, KEY_R, KEY_F, KEY_V
+};
+
+
+// Chip-8 key for a character, -1 if none
+static int KeypadKey(int ch) {
+    if (ch <= 0 || ch >= 128) return -1;
+    const char* found = strchr(KEYPAD_KEYS, tolower(ch));
+    return found ? found - KEYPAD_KEYS : -1;
+}
+
+Input::Input(FILE* terminal, const char* evdev_path, bool &success) : terminal(terminal) {
+    if (evdev_path != nullptr) {
+        evdev_fd = open(evdev_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (evdev_fd < 0) {
+            success = false;
+            return;
+        }
+        // kernel stamps on the same clock as steady_clock
+        int clock = CLOCK_MONOTONIC;
+        evdev_clock = (ioctl(evdev_fd, EVIOCSCLOCKID, &clock) == 0);
+    }
+    if (pipe(wake) != 0) {
+        success = false;
+        return;
+    }
+
+    // push kitty flags 1 | 2 | 8 (disambiguate, event types, all keys as
+    // escape codes) and query them; the device attributes answer (CSI c)
+    // comes last, so a terminal without the protocol still replies
+    fputs("\033[>11u\033[?u\033[c", terminal);
+    fflush(terminal);
+
+    reader = std::thread(&Input::Reader, this);
+}
+
+Input::~Input() {
+    if (reader.joinable()) {
+        fputs("\033[<u", terminal); // pop the kitty flags
+        fflush(terminal);
+        if (write(wake[1], "", 1) < 0) {}
+        reader.join();
+    }
+    for (int fd : {wake[0], wake[1], evdev_fd}) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+// move the events queued since the last call to `events`, waiting up
+// to `timeout` ms for one if there are none yet
+void Input::Events(std::vector<KeyEvent> &events, int timeout) {
+    if (!pending && timeout <= 0) return;
+    std::unique_lock<std::mutex> guard(lock);
+    if (!pending) {
+        arrived.wait_for(guard, std::chrono::milliseconds(timeout), [this] { return pending.load(); });
+        if (!pending) return;
+    }
+    events.insert(events.end(), queue.begin(), queue.end());
+    queue.clear();
+    pending = false;
+}
+
+// "kitty", "evdev" or "legacy"
+const char* Input::Backend() const {
+    if (evdev_fd >= 0) return "evdev";
+    return kitty ? "kitty" : "legacy";
+}
+
+void Input::Push(int key, int type, std::chrono::steady_clock::time_point time) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        queue.push_back({key, type, time});
+        pending = true;
+    }
+    arrived.notify_one();
+}
+
+void Input::Reader() {
+    pollfd fds[3] = {
+        { wake[0],      POLLIN, 0 },
+        { STDIN_FILENO, POLLIN, 0 },
+        { evdev_fd,     POLLIN, 0 }, // ignored by poll() when -1
+    };
+
+    while (true) {
+        // a lone ESC is the ESC key, unless the rest of a sequence follows
+        int ready = poll(fds, 3, partial.empty() ? -1 : ESC_TIMEOUT);
+        auto now = std::chrono::steady_clock::now();
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (ready == 0) {
+            if (partial == "\033") Push(INPUT_ESC, KEY_EVENT_PRESS, now);
+            partial.clear();
+            continue;
+        }
+        if (fds[0].revents) return; // ~Input()
+
+        if (fds[1].revents) {
+            char buffer[256];
+            ssize_t size = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (size > 0) {
+                partial.append(buffer, size);
+                Parse(now);
+            } else {
+                fds[1].fd = -1; // EOF, keep serving evdev
+            }
+        }
+        if (fds[2].revents) ReadEvdev();
+    }
+}
+
+// terminal bytes ==> events, incomplete sequences stay in `partial`
+void Input::Parse(std::chrono::steady_clock::time_point time) {
+    size_t i = 0;
+    while (i < partial.size()) {
+        unsigned char ch = partial[i];
+
+        // plain byte: a press, the terminal never says when it ends
+        if (ch != 0x1B) {
+            if (ch == '\t') {
+                Push(INPUT_TAB, KEY_EVENT_PRESS, time);
+            } else if (KeypadKey(ch) >= 0 && evdev_fd < 0) {
+                Push(KeypadKey(ch), KEY_EVENT_PRESS, time);
+            }
+            i ++;
+            continue;
+        }
+
+        if (i + 1 >= partial.size()) break; // ESC, or the start of a sequence
+        if (partial[i + 1] == '[') {
+            // CSI <params> <final byte 0x40 ~ 0x7E>
+            size_t end = i + 2;
+            while (end < partial.size() && (partial[end] < 0x40 || partial[end] > 0x7E)) end ++;
+            if (end >= partial.size()) break;
+            ParseCSI(partial.substr(i + 2, end - i - 2), partial[end], time);
+            i = end + 1;
+        } else if (partial[i + 1] == 'O') {
+            // SS3 <byte>: F1 ~ F4 and cursor keys in application mode
+            if (i + 2 >= partial.size()) break;
+            i += 3;
+        } else {
+            Push(INPUT_ESC, KEY_EVENT_PRESS, time);
+            i ++;
+        }
+    }
+    partial.erase(0, i);
+    if (partial.size() > 64) partial.clear(); // not a sequence we know
+}
+
+// "code[:alternates] ; modifiers[:event] ; text" + 'u' (kitty)
+// or "number ; modifiers[:event]" + '~' (F5 ~ F12)
+void Input::ParseCSI(const std::string &params, char final, std::chrono::steady_clock::time_point time) {
+    if (!params.empty() && params[0] == '?') {
+        if (final == 'u') kitty = true; // answer to CSI ? u
+        return;                         // or the CSI ? ... c that ends the query
+    }
+    if (final != 'u' && final != '~') return;
+
+    int code = atoi(params.c_str());
+    int type = KEY_EVENT_PRESS;
+    size_t modifiers = params.find(';');
+    if (modifiers != std::string::npos) {
+        size_t colon = params.find(':', modifiers);
+        if (colon < params.find(';', modifiers + 1)) type = atoi(params.c_str() + colon + 1);
+        if (type < KEY_EVENT_PRESS || type > KEY_EVENT_RELEASE) type = KEY_EVENT_PRESS;
+    }
+
+    if (final == '~') {
+        const int numbers[] = { 15, 17, 18, 19, 20, 21, 23, 24 }; // F5 ~ F12
+        for (int n = 0; n < 8; n ++) {
+            if (code == numbers[n]) Push(INPUT_F(5 + n), type, time);
+        }
+    } else if (code == 27) {
+        Push(INPUT_ESC, type, time);
+    } else if (code == '\t') {
+        Push(INPUT_TAB, type, time);
+    } else if (KeypadKey(code) >= 0 && evdev_fd < 0) {
+        Push(KeypadKey(code), type, time);
+    }
+}
+
+void Input::ReadEvdev() {
+    input_event events[64];
+    ssize_t size = read(evdev_fd, events, sizeof(events));
+    auto now = std::chrono::steady_clock::now();
+
+    for (ssize_t i = 0; i < size / (ssize_t)sizeof(input_event); i ++) {
+        const input_event &event = events[i];
+        if (event.type != EV_KEY) continue;
+
+        for (int key = 0; key < 16; key ++) {
+            if (event.code != EVDEV_KEYS[key]) continue;
+            int type = (event.value == 0) ? KEY_EVENT_RELEASE :
+                       (event.value == 1) ? KEY_EVENT_PRESS   : KEY_EVENT_REPEAT;
+            auto time = now;
+            if (evdev_clock) {
+                time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::seconds(event.input_event_sec) + std::chrono::microseconds(event.input_event_usec)));
+            }
+            Push(key, type, time);
+        }
+    }
+}
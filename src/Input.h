@@ -0,0 +1,77 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define KEY_EVENT_PRESS   1
+#define KEY_EVENT_REPEAT  2
+#define KEY_EVENT_RELEASE 3
+
+// KeyEvent::key beyond the keypad (0x0 ~ 0xF)
+#define INPUT_ESC  0x100
+#define INPUT_TAB  0x101
+#define INPUT_F(n) (0x110 + (n))
+
+
+struct KeyEvent {
+    int key;  // Chip-8 key 0x0 ~ 0xF, or INPUT_*
+    int type; // KEY_EVENT_*
+    std::chrono::steady_clock::time_point time; // when it reached the emulator
+};
+
+// Keyboard reader on its own thread, so every event is stamped the moment
+// it arrives.
+//
+// On the terminal it asks for the kitty keyboard protocol (CSI > 11 u:
+// every key as an escape code, with press / repeat / release), which
+// gives real key releases and any number of keys held at once. Terminals
+// that do not answer the query keep sending plain bytes: those are
+// presses only, and the caller has to guess releases (see Releases()).
+// With an evdev device (/dev/input/event*) the keypad keys come from
+// the kernel instead, with releases, and the terminal only supplies
+// ESC / TAB / F-keys.
+class Input {
+  public:
+    // terminal: stream the protocol requests are written to (ncurses' output)
+    // evdev_path: keyboard device for the keypad, nullptr to use the terminal
+    Input(FILE* terminal, const char* evdev_path, bool &success);
+    ~Input();
+
+    // move the events queued since the last call to `events`, waiting up
+    // to `timeout` ms for one if there are none yet
+    void Events(std::vector<KeyEvent> &events, int timeout = 0);
+    // false while only presses are reported (plain terminal bytes)
+    bool Releases() const { return kitty || evdev_fd >= 0; }
+    // "kitty", "evdev" or "legacy"
+    const char* Backend() const;
+
+  private:
+    FILE*                 terminal;
+    int                   evdev_fd = -1;
+    bool                  evdev_clock = false; // its stamps are CLOCK_MONOTONIC
+    int                   wake[2]  = {-1, -1}; // written to stop Reader()
+    std::thread           reader;
+    std::atomic<bool>     kitty{false};   // terminal answered the protocol query
+    std::atomic<bool>     pending{false}; // queue not empty
+    std::mutex            lock;
+    std::condition_variable arrived;      // Push() ==> Events()
+    std::vector<KeyEvent> queue;
+    std::string           partial;        // escape sequence split across reads
+
+    void Reader();
+    void Push(int key, int type, std::chrono::steady_clock::time_point time);
+    // terminal bytes ==> events, incomplete sequences stay in `partial`
+    void Parse(std::chrono::steady_clock::time_point time);
+    void ParseCSI(const std::string &params, char final, std::chrono::steady_clock::time_point time);
+    void ReadEvdev();
+};
+
+#endif // __INPUT_H__
@@ -0,0 +1,349 @@
+#include "Lockstep.h"
+
+#include <algorithm> // std::min(), std::max()
+#include <cstdint>
+#include <cstring> // memcpy()
+
+#define VF 0xF
+
+
+// byte mask (0x00/0xFF per lane) ==> 4 words, so masks never cross a call
+// boundary as 32-byte vectors (the AVX2 clone and its callees differ in ABI)
+#define TO_WORDS(words, mask) \
+    uint64_t words[4];        \
+    { u8x32 bits = (u8x32)(mask); memcpy(words, &bits, sizeof(words)); }
+
+
+Lockstep::Lockstep(int lanes) {
+    this->lanes = std::min(std::max(lanes, 1), LOCKSTEP_MAX_LANES);
+    chips.resize(this->lanes);
+    for (int i = 0; i < this->lanes; i ++) chips[i].Seed(i);
+
+    uint8_t bytes[LOCKSTEP_MAX_LANES] = {};
+    for (int i = 0; i < this->lanes; i ++) bytes[i] = 0xFF;
+    memcpy(active, bytes, sizeof(active));
+}
+
+// load the same ROM into every lane
+void Lockstep::LoadROM(const uint8_t* data, size_t size, bool &success) {
+    for (Chip8 &chip : chips) chip.LoadROM(data, size, success);
+}
+
+// run `cycles` instructions on every lane
+void Lockstep::Run(uint64_t cycles, bool &success) {
+    bool together = Gather();
+
+    while (cycles > 0 && success) {
+        if (together) {
+            uint64_t done = RunVector(cycles, together, success);
+            cycles -= done;
+            vector_cycles += done;
+            if (cycles == 0 || !success) break;
+            // diverged (possibly on the last cycle, so only `together` tells):
+            // RunVector() already handed the state back to the chips, and a
+            // stint shorter than the scalar run before it did not pay off
+            if (done >= (uint64_t)scalar_run) scalar_run = LOCKSTEP_SCALAR_RUN;
+            else scalar_run = std::min(2 * scalar_run, LOCKSTEP_SCALAR_MAX);
+        }
+
+        uint64_t run = std::min<uint64_t>(cycles, scalar_run);
+        RunScalar(run, success);
+        cycles -= run;
+        scalar_cycles += run;
+        together = Gather();
+        if (!together) scalar_run = std::min(2 * scalar_run, LOCKSTEP_SCALAR_MAX);
+    }
+
+    // vectors ==> chips only if they still hold the state; after a
+    // divergence the chips have their own pcs already
+    if (together) Scatter();
+}
+
+// chips ==> vectors, return false if the lanes do not share a pc
+bool Lockstep::Gather() {
+    for (int i = 1; i < lanes; i ++) {
+        if (chips[i].pc != chips[0].pc) return false;
+    }
+    for (int i = 0; i < lanes; i ++) GatherLane(i);
+    pc = chips[0].pc;
+    return true;
+}
+
+void Lockstep::GatherLane(int lane) {
+    const Chip8 &chip = chips[lane];
+    for (int r = 0; r < 16; r ++) V[r][lane] = chip.registers[r];
+    index[lane / 16][lane % 16] = chip.index;
+    delay_timer[lane] = chip.delay_timer;
+    sound_timer[lane] = chip.sound_timer;
+}
+
+// vectors ==> chips
+void Lockstep::Scatter() {
+    for (int i = 0; i < lanes; i ++) {
+        ScatterLane(i);
+        chips[i].pc = pc;
+    }
+}
+
+void Lockstep::ScatterLane(int lane) {
+    Chip8 &chip = chips[lane];
+    for (int r = 0; r < 16; r ++) chip.registers[r] = V[r][lane];
+    chip.index = index[lane / 16][lane % 16];
+    chip.delay_timer = delay_timer[lane];
+    chip.sound_timer = sound_timer[lane];
+}
+
+bool Lockstep::AllSet(const uint64_t (&mask)[4]) const {
+    for (int i = 0; i < 4; i ++) {
+        if ((mask[i] & active[i]) != active[i]) return false;
+    }
+    return true;
+}
+
+bool Lockstep::NoneSet(const uint64_t (&mask)[4]) const {
+    for (int i = 0; i < 4; i ++) {
+        if ((mask[i] & active[i]) != 0) return false;
+    }
+    return true;
+}
+
+// remember addresses a store may have made different between lanes
+void Lockstep::MarkStore(uint16_t at, uint16_t opcode) {
+    int length = 0;
+    if ((opcode & 0xF0FF) == 0xF033) length = 3;
+    if ((opcode & 0xF0FF) == 0xF055) length = ((opcode & 0x0F00) >> 8) + 1;
+    for (int i = 0; i < length; i ++) written[(at + i) & 0xFFF] = true;
+}
+
+// skip opcodes: `taken` is 0xFF in lanes that skip
+bool Lockstep::Skip(const uint64_t (&taken)[4]) {
+    if (AllSet(taken)) {
+        pc += 2;
+        return true;
+    }
+    if (NoneSet(taken)) return true;
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(taken);
+    for (int i = 0; i < lanes; i ++) {
+        chips[i].pc = pc + (bytes[i] ? 2 : 0);
+    }
+    return false;
+}
+
+// registers Chip8::Execute(op) may read / write, as masks of V0-VF
+// (an opcode that only sometimes writes a register also reads it, so the
+// chip's copy is current either way)
+template <class Q>
+static void Footprint(uint16_t op, uint16_t &reads, uint16_t &writes, bool &index_reads, bool &index_writes) {
+    uint8_t  x      = (op & 0x0F00) >> 8;
+    uint8_t  y      = (op & 0x00F0) >> 4;
+    uint16_t upto_x = (2 << x) - 1; // V0-Vx
+
+    reads = writes = 0;
+    index_reads = index_writes = false;
+    switch (op & 0xF000) {
+        case 0xB000: reads  = 1 << (Q::jump_vx ? x : 0);                          break;
+        case 0xC000: writes = 1 << x;                                             break;
+        case 0xD000: reads  = (1 << x) | (1 << y); writes = 1 << VF; index_reads = true; break;
+        case 0xE000: reads  = 1 << x;                                             break;
+        case 0xF000:
+            switch (op & 0x00FF) {
+                case 0x0A: reads = writes = 1 << x;                               break;
+                case 0x30: reads = 1 << x; index_writes = true;                   break;
+                case 0x33: reads = 1 << x; index_reads  = true;                   break;
+                case 0x55: reads  = upto_x; index_reads = true; index_writes = Q::index_moves; break;
+                case 0x65: writes = upto_x; index_reads = true; index_writes = Q::index_moves; break;
+                case 0x75: reads  = upto_x;                                       break;
+                case 0x85: writes = upto_x;                                       break;
+            }
+            break;
+        // 0nnn, 1nnn, 2nnn: pc, stack and video only
+    }
+}
+
+// execute `op` (pc already advanced) per lane, return false on divergence
+template <class Q>
+bool Lockstep::ExecuteLanes(uint16_t op) {
+    uint16_t reads, writes;
+    bool     index_reads, index_writes;
+    Footprint<Q>(op, reads, writes, index_reads, index_writes);
+
+    bool same_pc = true;
+    for (int i = 0; i < lanes; i ++) {
+        Chip8 &chip = chips[i];
+        for (uint16_t m = reads; m != 0; m &= m - 1) {
+            chip.registers[__builtin_ctz(m)] = V[__builtin_ctz(m)][i];
+        }
+        if (index_reads) chip.index = index[i / 16][i % 16];
+
+        uint16_t at = chip.index;
+        chip.pc = pc;
+        chip.Execute(op);
+        MarkStore(at, op);
+
+        for (uint16_t m = writes; m != 0; m &= m - 1) {
+            V[__builtin_ctz(m)][i] = chip.registers[__builtin_ctz(m)];
+        }
+        if (index_writes) index[i / 16][i % 16] = chip.index;
+        same_pc &= (chip.pc == chips[0].pc);
+    }
+    if (same_pc) pc = chips[0].pc;
+    return same_pc;
+}
+
+// zero-extend lanes 0-15 / 16-31 of a byte vector
+// (vectors passed by reference only, see TO_WORDS)
+static inline __attribute__((always_inline))
+void Widen(u16x16 &wide, const u8x32 &bytes, int half) {
+    u8x16 part;
+    memcpy(&part, reinterpret_cast<const uint8_t*>(&bytes) + 16 * half, sizeof(part));
+    wide = __builtin_convertvector(part, u16x16);
+}
+
+// run up to `cycles` in lockstep with quirk profile Q, stop early when
+// lanes diverge; inlined into RunVector(), once per profile and target
+template <class Q>
+inline __attribute__((always_inline))
+uint64_t Lockstep::RunVectorAs(uint64_t cycles, bool &converged, bool &success) {
+    const uint8_t* memory = chips[0].memory;
+
+    for (uint64_t done = 0; done < cycles; done ++) {
+        // invalid pc
+        if (pc + 1 >= 4096 || pc % 2 == 1) {
+            success   = false;
+            converged = false;
+            Scatter();
+            return done;
+        }
+
+        // Fetch, lanes only need comparing where some lane stored to
+        uint16_t op = (memory[pc] << 8) | memory[pc + 1];
+        if (written[pc] || written[pc + 1]) {
+            for (int i = 1; i < lanes; i ++) {
+                if (chips[i].memory[pc] != memory[pc] || chips[i].memory[pc + 1] != memory[pc + 1]) {
+                    converged = false;
+                    Scatter();
+                    return done;
+                }
+            }
+        }
+        pc += 2;
+
+        uint8_t  x   = (op & 0x0F00) >> 8;
+        uint8_t  y   = (op & 0x00F0) >> 4;
+        uint8_t  kk  = op & 0x00FF;
+        uint16_t nnn = op & 0x0FFF;
+        bool together = true;
+
+        // Decode & Execute
+        switch (op & 0xF000) {
+            case 0x1000: pc = nnn;                                            break;
+            case 0x3000: { TO_WORDS(m, V[x] == kk);   together = Skip(m); }   break;
+            case 0x4000: { TO_WORDS(m, V[x] != kk);   together = Skip(m); }   break;
+            case 0x5000: { TO_WORDS(m, V[x] == V[y]); together = Skip(m); }   break;
+            case 0x9000: { TO_WORDS(m, V[x] != V[y]); together = Skip(m); }   break;
+            case 0x6000: V[x] = (u8x32){} + kk;                               break;
+            case 0x7000: V[x] += kk;                                          break;
+            case 0xA000: index[0] = index[1] = (u16x16){} + nnn;              break;
+            case 0x8000:
+                switch (op & 0x000F) {
+                    case 0x0: V[x]  = V[y];                                    break;
+                    case 0x1: V[x] |= V[y];                                    break;
+                    case 0x2: V[x] &= V[y];                                    break;
+                    case 0x3: V[x] ^= V[y];                                    break;
+                    case 0x4: {
+                        u8x32 sum = V[x] + V[y];
+                        V[VF] = (u8x32)(sum < V[x]) & 1; // carry
+                        V[x]  = sum;
+                        break;
+                    }
+                    case 0x5:
+                        V[VF] = (u8x32)(V[x] > V[y]) & 1;
+                        V[x]  = V[x] - V[y];
+                        break;
+                    case 0x6: {
+                        u8x32 value = Q::shift_vy ? V[y] : V[x];
+                        V[VF] = value & 1;
+                        V[x]  = value >> 1;
+                        break;
+                    }
+                    case 0x7:
+                        V[VF] = (u8x32)(V[y] > V[x]) & 1;
+                        V[x]  = V[y] - V[x];
+                        break;
+                    case 0xE: {
+                        u8x32 value = Q::shift_vy ? V[y] : V[x];
+                        V[VF] = value >> 7;
+                        V[x]  = value << 1;
+                        break;
+                    }
+                }
+                break;
+            case 0xF000:
+                switch (kk) {
+                    case 0x07: V[x] = delay_timer;                             break;
+                    case 0x15: delay_timer = V[x];                             break;
+                    case 0x18: sound_timer = V[x];                             break;
+                    case 0x1E:
+                        for (int half = 0; half < 2; half ++) {
+                            u16x16 wide;
+                            Widen(wide, V[x], half);
+                            index[half] += wide;
+                        }
+                        break;
+                    case 0x29:
+                        for (int half = 0; half < 2; half ++) {
+                            u16x16 wide;
+                            Widen(wide, V[x], half);
+                            index[half] = FONTSET_START_ADDRESS + 5 * wide;
+                        }
+                        break;
+                    default:
+                        together = ExecuteLanes<Q>(op);
+                        break;
+                }
+                break;
+            default:
+                // 00xx, 2nnn, Bnnn, Cxkk, Dxyn, Ex9E, ExA1
+                together = ExecuteLanes<Q>(op);
+                break;
+        }
+
+        // run timer if set
+        delay_timer -= (u8x32)(delay_timer != 0) & 1;
+        sound_timer -= (u8x32)(sound_timer != 0) & 1;
+
+        if (!together) {
+            // per-lane pcs were already written by Skip() / ExecuteLanes()
+            for (int i = 0; i < lanes; i ++) ScatterLane(i);
+            converged = false;
+            return done + 1;
+        }
+    }
+    return cycles;
+}
+
+// run up to `cycles` in lockstep, stop early when lanes diverge and clear
+// `converged` once the state is back in the chips
+// built for AVX2 and for the baseline (SSE2) target, picked at load time
+__attribute__((target_clones("avx2", "default")))
+uint64_t Lockstep::RunVector(uint64_t cycles, bool &converged, bool &success) {
+    // every lane shares lane 0's profile
+    switch (chips[0].quirks) {
+        case QUIRKS_COSMAC: return RunVectorAs<QuirksPolicy<QUIRKS_COSMAC>>(cycles, converged, success);
+        case QUIRKS_SCHIP:  return RunVectorAs<QuirksPolicy<QUIRKS_SCHIP>>(cycles, converged, success);
+        case QUIRKS_XOCHIP: return RunVectorAs<QuirksPolicy<QUIRKS_XOCHIP>>(cycles, converged, success);
+        default:            return RunVectorAs<QuirksPolicy<QUIRKS_DEFAULT>>(cycles, converged, success);
+    }
+}
+
+// run `cycles` on every lane independently
+void Lockstep::RunScalar(uint64_t cycles, bool &success) {
+    for (Chip8 &chip : chips) {
+        for (uint64_t i = 0; i < cycles && success; i ++) {
+            uint16_t at = chip.index;
+            chip.Cycle(success);
+            MarkStore(at, chip.opcode);
+        }
+    }
+}
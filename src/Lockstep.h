@@ -0,0 +1,88 @@
+#ifndef __LOCKSTEP_H__
+#define __LOCKSTEP_H__
+
+#include "Chip8.h"
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const int LOCKSTEP_MAX_LANES   = 32;
+const int LOCKSTEP_SCALAR_RUN  = 32;   // cycles per lane between convergence checks
+const int LOCKSTEP_SCALAR_MAX  = 4096; // ... after repeatedly failing to reconverge
+
+typedef uint8_t  u8x32  __attribute__((vector_size(32)));
+typedef uint8_t  u8x16  __attribute__((vector_size(16)));
+typedef uint16_t u16x16 __attribute__((vector_size(32)));
+
+
+// Many instances of the same ROM stepped together.
+//
+// While every lane sits at the same pc and fetches the same opcode the
+// registers, index and timers live in structure-of-arrays form (one 32-byte
+// vector per register, one byte per lane) and ALU/timer/skip opcodes run
+// as SIMD kernels for all lanes at once. Everything else (memory, stack,
+// video, keypad, RNG) stays in one Chip8 per lane; opcodes touching it run
+// per lane through Chip8::Execute(), moving only the registers the opcode
+// reads or writes between the vectors and the chips. Once lanes disagree on
+// pc they run as plain Chip8::Cycle() until their pcs meet again; the
+// interval between checks doubles while lanes keep failing to stay together.
+class Lockstep {
+  public:
+    // lanes: number of instances, clamped to [1, LOCKSTEP_MAX_LANES]
+    Lockstep(int lanes);
+
+    // load the same ROM into every lane
+    void LoadROM(const uint8_t* data, size_t size, bool &success);
+    // run `cycles` instructions on every lane
+    void Run(uint64_t cycles, bool &success);
+
+    // per-lane state (keypad, seed, video, quirks, ...), valid between Run() calls
+    // every lane must use the same quirk profile
+    Chip8& Lane(int lane) { return chips[lane]; }
+    int    Lanes() const  { return lanes; }
+
+    uint64_t vector_cycles = 0; // cycles executed for all lanes together
+    uint64_t scalar_cycles = 0; // cycles executed lane by lane (per lane)
+
+  private:
+    int                lanes;
+    std::vector<Chip8> chips;
+    uint64_t           active[4];      // byte mask of lanes in use, as 4 words
+    int                scalar_run = LOCKSTEP_SCALAR_RUN; // current convergence check interval
+
+    // structure-of-arrays state, only valid in lockstep
+    u8x32              V[16];
+    u16x16             index[2];       // lanes 0-15, lanes 16-31
+    u8x32              delay_timer;
+    u8x32              sound_timer;
+    uint16_t           pc;
+
+    std::bitset<4096>  written;        // addresses any lane may have stored to
+
+    // chips ==> vectors, return false if the lanes do not share a pc
+    bool Gather();
+    void GatherLane(int lane);
+    // vectors ==> chips
+    void Scatter();
+    void ScatterLane(int lane);
+
+    // run up to `cycles` in lockstep, stop early when lanes diverge and clear
+    // `converged` once the state is back in the chips
+    uint64_t RunVector(uint64_t cycles, bool &converged, bool &success);
+    template <class Q> uint64_t RunVectorAs(uint64_t cycles, bool &converged, bool &success);
+    // run `cycles` on every lane independently
+    void RunScalar(uint64_t cycles, bool &success);
+    // execute `op` (pc already advanced) per lane, return false on divergence
+    template <class Q> bool ExecuteLanes(uint16_t op);
+    // skip opcodes: `taken` is 0xFF in lanes that skip
+    bool Skip(const uint64_t (&taken)[4]);
+
+    // remember addresses a store may have made different between lanes
+    void MarkStore(uint16_t at, uint16_t opcode);
+    bool AllSet(const uint64_t (&mask)[4]) const;
+    bool NoneSet(const uint64_t (&mask)[4]) const;
+};
+
+#endif // __LOCKSTEP_H__
@@ -0,0 +1,173 @@
+#include "Metrics.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib> // strtoull()
+#include <cstring> // strncpy(), strstr()
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+Metrics::Metrics() {
+    last_update = std::chrono::steady_clock::now();
+    // read only every METRICS_INTERVAL, so drawing never pays for it
+    io_fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+    not_terminal = Written(); // everything before the first frame
+}
+
+Metrics::~Metrics() {
+    if (io_fd >= 0) close(io_fd);
+    for (int fd : closing) close(fd);
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+}
+
+void Metrics::Export(const std::string target, bool &success) {
+    if (target.compare(0, 5, "unix:") != 0) {
+        file_path = target;
+        return;
+    }
+
+    socket_path = target.substr(5);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        success = false;
+        return;
+    }
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socket_path.c_str()); // stale socket from an earlier run
+    if (listen_fd < 0
+            || bind(listen_fd, (sockaddr*)&address, sizeof(address)) != 0
+            || listen(listen_fd, 8) != 0) {
+        success = false;
+    }
+}
+
+// cheap unless METRICS_INTERVAL has passed, then recompute and export
+bool Metrics::Update(uint64_t instructions, const FrameStats &stats) {
+    auto now = std::chrono::steady_clock::now();
+    double dt = std::chrono::duration<double>(now - last_update).count();
+    if (dt * 1000 < METRICS_INTERVAL) return false;
+
+    uint64_t frames  = stats.frames          - last.frames;
+    uint64_t presses = stats.latency_samples - last.latency_samples;
+    uint64_t events  = stats.keypad_samples  - last.keypad_samples;
+
+    // the only other writes of this thread are the exports below (send()s
+    // do not count)
+    uint64_t written  = Written();
+    uint64_t terminal = (written > not_terminal) ? written - not_terminal : 0;
+
+    instructions_per_sec   = (instructions - last_instructions) / dt;
+    frames_per_sec         = frames / dt;
+    terminal_bytes_per_sec = (terminal - terminal_bytes) / dt;
+    render_ms  = frames  ? 1000 * (stats.render_time  - last.render_time)  / frames  : 0;
+    // keep the last value through intervals without keypresses
+    if (presses) latency_ms = 1000 * (stats.latency_time - last.latency_time) / presses;
+    if (events)  keypad_ms  = 1000 * (stats.keypad_time  - last.keypad_time)  / events;
+
+    this->instructions = instructions;
+    terminal_bytes     = terminal;
+    totals             = stats;
+    last_instructions  = instructions;
+    last               = stats;
+    last_update        = now;
+
+    if (!file_path.empty() || listen_fd >= 0) {
+        std::string text = Text();
+        if (!file_path.empty()) {
+            uint64_t before = Written();
+            WriteFile(text);
+            not_terminal += Written() - before;
+        }
+        if (listen_fd >= 0)     Serve(text);
+    }
+    return true;
+}
+
+// bytes the drawing thread has passed to write() so far, 0 if unknown
+uint64_t Metrics::Written() const {
+    char text[512];
+    ssize_t size = (io_fd >= 0) ? pread(io_fd, text, sizeof(text) - 1, 0) : -1;
+    if (size <= 0) return 0;
+    text[size] = '\0';
+    const char* wchar = strstr(text, "wchar:");
+    return wchar ? strtoull(wchar + 6, nullptr, 10) : 0;
+}
+
+// Prometheus text exposition format
+std::string Metrics::Text() const {
+    char buffer[2048];
+    snprintf(buffer, sizeof(buffer),
+        "# HELP chip8_instructions_total Emulated instructions executed.\n"
+        "# TYPE chip8_instructions_total counter\n"
+        "chip8_instructions_total %llu\n"
+        "# HELP chip8_instructions_per_second Emulated instructions per second.\n"
+        "# TYPE chip8_instructions_per_second gauge\n"
+        "chip8_instructions_per_second %.1f\n"
+        "# HELP chip8_frames_total Screens presented.\n"
+        "# TYPE chip8_frames_total counter\n"
+        "chip8_frames_total %llu\n"
+        "# HELP chip8_frames_per_second Screens presented per second.\n"
+        "# TYPE chip8_frames_per_second gauge\n"
+        "chip8_frames_per_second %.1f\n"
+        "# HELP chip8_render_seconds Time spent drawing one screen.\n"
+        "# TYPE chip8_render_seconds gauge\n"
+        "chip8_render_seconds %.9f\n"
+        "# HELP chip8_terminal_bytes_total Bytes written to the terminal.\n"
+        "# TYPE chip8_terminal_bytes_total counter\n"
+        "chip8_terminal_bytes_total %llu\n"
+        "# HELP chip8_input_latency_seconds Time from keypress to the next presented screen.\n"
+        "# TYPE chip8_input_latency_seconds gauge\n"
+        "chip8_input_latency_seconds %.9f\n"
+        "# HELP chip8_keypad_latency_seconds Time from a key event reaching the emulator to the keypad.\n"
+        "# TYPE chip8_keypad_latency_seconds gauge\n"
+        "chip8_keypad_latency_seconds %.9f\n",
+        (unsigned long long)instructions, instructions_per_sec,
+        (unsigned long long)totals.frames, frames_per_sec,
+        render_ms / 1000,
+        (unsigned long long)terminal_bytes,
+        latency_ms / 1000,
+        keypad_ms / 1000);
+    return buffer;
+}
+
+// write next to the target and rename, so scrapers never see half a file
+void Metrics::WriteFile(const std::string &text) {
+    std::string temp_path = file_path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "w");
+    if (file == nullptr) return;
+    fwrite(text.data(), 1, text.size(), file);
+    fclose(file);
+    rename(temp_path.c_str(), file_path.c_str());
+}
+
+// answer every pending connection, never waits on a client
+void Metrics::Serve(const std::string &text) {
+    char discard[1024];
+    for (int fd : closing) {
+        while (read(fd, discard, sizeof(discard)) > 0) {}
+        close(fd);
+    }
+    closing.clear();
+
+    std::string response = "HTTP/1.0 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(text.size()) + "\r\n\r\n" + text;
+    int fd;
+    while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        while (read(fd, discard, sizeof(discard)) > 0) {} // request, if already sent
+        send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+        shutdown(fd, SHUT_WR);
+        closing.push_back(fd);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define METRICS_INTERVAL 500 // ms between HUD refreshes / exports
+
+
+// Raw counters kept by the front end, only ever growing
+struct FrameStats {
+    uint64_t frames          = 0; // screens presented
+    double   render_time     = 0; // seconds spent drawing them
+    uint64_t latency_samples = 0; // keypresses that reached the screen
+    double   latency_time    = 0; // seconds from keypress to the next presented screen
+    uint64_t keypad_samples  = 0; // key events applied to the keypad
+    double   keypad_time     = 0; // seconds from their arrival to the keypad
+};
+
+// Rates derived from the counters, refreshed every METRICS_INTERVAL and
+// optionally exported in Prometheus text format
+class Metrics {
+  public:
+    // construct on the thread that draws: its write() total is what
+    // reaches the terminal, as ncurses write()s it directly
+    Metrics();
+    ~Metrics();
+
+    // target: a file (rewritten atomically), or "unix:<path>" to answer
+    // every connection on that socket with the current values over HTTP
+    void Export(const std::string target, bool &success);
+
+    // cheap unless METRICS_INTERVAL has passed, then recompute and export;
+    // return true when new values are ready (i.e. the HUD should redraw)
+    bool Update(uint64_t instructions, const FrameStats &stats);
+
+    double   instructions_per_sec = 0;
+    double   frames_per_sec       = 0;
+    double   render_ms            = 0; // per frame, last interval
+    double   latency_ms           = 0; // per keypress, last interval
+    double   keypad_ms            = 0; // per key event, last interval
+    double   terminal_bytes_per_sec = 0;
+    uint64_t instructions         = 0;
+    uint64_t terminal_bytes       = 0; // written to the terminal so far
+    FrameStats totals;
+
+  private:
+    std::chrono::steady_clock::time_point last_update;
+    uint64_t   last_instructions = 0;
+    FrameStats last;
+    int        io_fd = -1;       // /proc I/O counters of the drawing thread, -1 if unavailable
+    uint64_t   not_terminal = 0; // bytes in its write() total that did not go to the terminal
+
+    std::string file_path;
+    int         listen_fd = -1;
+    std::string socket_path;
+    std::vector<int> closing; // answered connections, closed on the next Update()
+
+    // bytes the drawing thread has passed to write() so far, 0 if unknown
+    uint64_t Written() const;
+    std::string Text() const;
+    void WriteFile(const std::string &text);
+    void Serve(const std::string &text);
+};
+
+#endif // __METRICS_H__
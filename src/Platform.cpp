@@ -1,17 +1,28 @@
 #include "Platform.h"
+#include "Quadrants.h"
 
+#include <algorithm> // std::min(), std::max()
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstring> // strlen()
 #include <filesystem>
 #include <ncurses.h>
 #include <string>
+#include <thread>
 
 #define KEY_ESC 27
 
+#define HUD_ROW 16 // below the debug panel
+#define DEBUG_PANE_WIDTH 30
+#define PREVIEW_POLL 50         // ms between preview redraws in SelectROM()
+#define PREVIEW_FRAME_TIME 250  // ms each preview frame is shown
+
+
 
 Platform::Platform(const int min_width, const int min_height, bool &success) {
     success = true;
+    quadrants = Quadrants(); // block characters if the terminal takes UTF-8
     initscr();
     cbreak();
     noecho();
@@ -31,12 +42,13 @@ Platform::Platform(const int min_width, const int min_height, bool &success) {
 }
 
 Platform::~Platform() {
+    input.reset(); // restores the keyboard protocol while ncurses still runs
     endwin();
     printf("Program finished. Exiting...\n");
 }
 
 std::string Platform::SelectROM(const char* base_dir, bool &success) {
-    timeout(-1);
+    timeout(PREVIEW_POLL); // keep animating the preview between keys
     mvprintw(row_start + 2, col_start + 2, "Selete a ROM to run: (UP/DOWN/ENTER)");
 
     // print and store the file list
@@ -49,6 +61,11 @@ std::string Platform::SelectROM(const char* base_dir, bool &success) {
         cnt ++;
     }
 
+    // previews of the highlighted ROM and its neighbours, rendered off this thread
+    PreviewPool previews(std::max(1u, std::min(4u, std::thread::hardware_concurrency())));
+    long preview_row = row_start + 4 + cnt + 1;
+    int wanted = -1;
+
     // handle input and print selector
     int sel = 0;
     int ch = ERR;
@@ -76,11 +93,19 @@ std::string Platform::SelectROM(const char* base_dir, bool &success) {
                 mvprintw(row_start + 4 + i, col_start + 4, "   ");
             }
         }
+        if (cnt > 0 && sel != wanted) {
+            std::vector<std::string> paths;
+            for (int d : {0, 1, -1, 2, -2}) paths.push_back(file_list[((sel + d) % cnt + cnt) % cnt]);
+            previews.Want(paths);
+            wanted = sel;
+        }
+        if (cnt > 0) DrawPreview(previews.Get(file_list[sel]).get(), preview_row, col_start + 8);
         move(LINES - 1, 0);
         refresh();
     } while(ch = getch());
 
     erase();
+    for (std::string &row : drawn) row.clear();
     timeout(TIMEOUT);
 
     // return selected path
@@ -88,38 +113,155 @@ std::string Platform::SelectROM(const char* base_dir, bool &success) {
 }
 
 void Platform::UpdateScreen(const uint32_t (&video)[VIDEO_HEIGHT][VIDEO_WIDTH]) {
-    for (long y = 0; y < VIDEO_HEIGHT; y ++) {
-        for (long x = 0; x < VIDEO_WIDTH; x ++) {
-            mvprintw(y + row_start, x + col_start,
-                    "%c", ((video[y][x] == 0) ? ' ' : '#') );
+    auto start_time = std::chrono::steady_clock::now();
+    char line[SCREEN_WIDTH * QUADRANT_MAX_BYTES];
+    for (long y = 0; y < SCREEN_HEIGHT; y ++) {
+        const uint32_t* top    = video[2 * y];
+        const uint32_t* bottom = video[2 * y + 1];
+        int size = 0;
+        for (long x = 0; x < SCREEN_WIDTH; x ++) {
+            const char* ch = quadrants[(top[2 * x]    & 1)      | (top[2 * x + 1]    & 2)
+                                     | (bottom[2 * x] & 1) << 2 | (bottom[2 * x + 1] & 2) << 2];
+            while (*ch) line[size ++] = *ch ++;
         }
+        // most frames change a few rows: skip the rest before ncurses sees them
+        if (drawn[y].compare(0, std::string::npos, line, size) == 0) continue;
+        drawn[y].assign(line, size);
+        mvaddnstr(y + row_start, col_start, line, size);
     }
     move(LINES - 1, 0);
     refresh();
+
+    auto end_time = std::chrono::steady_clock::now();
+    stats.frames ++;
+    stats.render_time += std::chrono::duration<double>(end_time - start_time).count();
+    if (input_pending) {
+        stats.latency_samples ++;
+        stats.latency_time += std::chrono::duration<double>(end_time - input_time).count();
+        input_pending = false;
+    }
 }
 
-void Platform::DebugInfo(const int cycle_delay, const Chip8 &chip8) {
-    mvprintw(row_start, col_start + VIDEO_WIDTH + 2, "[DebugInfo]");
+// performance overlay, toggled with TAB, redrawn only when `metrics` changed
+void Platform::HUD(const Metrics &metrics, const bool changed) {
+    long row = row_start + HUD_ROW;
+    long col = col_start + SCREEN_WIDTH + 2;
 
-    mvprintw(row_start + 2, col_start + VIDEO_WIDTH + 2, "cycle_delay: %d", cycle_delay);
+    if (hud_toggled && !hud_visible) {
+        for (int i = 0; i < 9; i ++) mvprintw(row + i, col, "%30s", "");
+    }
+    if (hud_visible && (changed || hud_toggled)) {
+        mvprintw(row,     col, "[HUD] (TAB to hide)");
+        mvprintw(row + 2, col, "instr/s:  %12.0f", metrics.instructions_per_sec);
+        mvprintw(row + 3, col, "frames/s: %12.1f", metrics.frames_per_sec);
+        mvprintw(row + 4, col, "render:   %9.3f ms", metrics.render_ms);
+        mvprintw(row + 5, col, "terminal: %9.1f KB/s", metrics.terminal_bytes_per_sec / 1024);
+        mvprintw(row + 6, col, "latency:  %9.1f ms", metrics.latency_ms);
+        mvprintw(row + 7, col, "keypad:   %9.3f ms", metrics.keypad_ms);
+        mvprintw(row + 8, col, "input:    %12s", input ? input->Backend() : "-");
+    }
+    if (hud_toggled || (hud_visible && changed)) {
+        move(LINES - 1, 0);
+        refresh();
+    }
+    hud_toggled = false;
+}
 
-    mvprintw(row_start + 4, col_start + VIDEO_WIDTH + 2, "opcode: %04X", chip8.opcode);
+void Platform::DebugInfo(const int cycle_delay, const Chip8 &chip8,
+                         const int run_ahead, const double run_ahead_cost) {
+    mvprintw(row_start, col_start + SCREEN_WIDTH + 2, "[DebugInfo]");
+
+    mvprintw(row_start + 2, col_start + SCREEN_WIDTH + 2, "cycle_delay: %d", cycle_delay);
+    mvprintw(row_start + 3, col_start + SCREEN_WIDTH + 2, "quirks: %s", QUIRKS[chip8.quirks].name);
+
+    mvprintw(row_start + 4, col_start + SCREEN_WIDTH + 2, "opcode: %04X", chip8.opcode);
 
     int pad_index;
-    mvprintw(row_start + 6, col_start + VIDEO_WIDTH + 2, "keypad:");
+    mvprintw(row_start + 6, col_start + SCREEN_WIDTH + 2, "keypad:");
     for (int i = 0; i < 4; i ++) {
         for (int j = 0; j < 4; j ++) {
             pad_index = i * 4 + j;
-            mvprintw(row_start + 7 + i, col_start + VIDEO_WIDTH + 2 + j * 2,
+            mvprintw(row_start + 7 + i, col_start + SCREEN_WIDTH + 2 + j * 2,
                     "%c", (chip8.keypad[pad_index] == 0) ? '-' :
                           (pad_index <= 9) ? (pad_index + 48) : (pad_index + 55));
         }
     }
+
+    mvprintw(row_start + 12, col_start + SCREEN_WIDTH + 2, "run_ahead: %d", run_ahead);
+    mvprintw(row_start + 13, col_start + SCREEN_WIDTH + 2, "  cost: %7.1f us/frame", run_ahead_cost);
     move(LINES - 1, 0);
     refresh();
 }
 
+// thumbnail of the highlighted ROM, a placeholder until it is rendered
+void Platform::DrawPreview(const Preview* preview, long row, long col) {
+    if (row + PREVIEW_ROWS + 2 > LINES) return; // no room below the list
+
+    mvprintw(row, col, "+%s+", std::string(PREVIEW_COLS, '-').c_str());
+    mvprintw(row + PREVIEW_ROWS + 1, col, "+%s+", std::string(PREVIEW_COLS, '-').c_str());
+
+    // loop through the frames, PREVIEW_FRAME_TIME each
+    int frame = -1;
+    if (preview != nullptr && preview->frames > 0) {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        frame = std::chrono::duration_cast<std::chrono::milliseconds>(now).count()
+                / PREVIEW_FRAME_TIME % preview->frames;
+    }
+
+    for (int i = 0; i < PREVIEW_ROWS; i ++) {
+        const char* text = (frame >= 0) ? preview->frame[frame][i] : "";
+        if (frame < 0 && i == PREVIEW_ROWS / 2) {
+            text = (preview == nullptr) ? "      rendering preview..." : "      no preview";
+        }
+        mvprintw(row + 1 + i, col, "|%-*s|", PREVIEW_COLS, text);
+    }
+}
+
+// registers, stack and disassembly around pc, left of the screen
+void Platform::DebugPane(const Chip8 &chip8, const Debugger &debugger) {
+    long col = col_start - DEBUG_PANE_WIDTH - 2;
+    if (col < 0) return; // terminal too narrow
+
+    for (int i = 0; i < SCREEN_HEIGHT; i ++) mvprintw(row_start + i, col, "%*s", DEBUG_PANE_WIDTH, "");
+
+    mvprintw(row_start,     col, "[Debugger]");
+    mvprintw(row_start + 1, col, "F5 run/pause F9 break F10 step");
+    mvprintw(row_start + 2, col, "%.*s", DEBUG_PANE_WIDTH,
+             debugger.paused ? debugger.reason.c_str() : "running");
+
+    for (int r = 0; r < 16; r ++) {
+        mvprintw(row_start + 4 + r / 4, col + (r % 4) * 7, "V%X %02X", r, chip8.registers[r]);
+    }
+    mvprintw(row_start + 8, col, "I  %03X  PC %03X", chip8.index, chip8.pc);
+    mvprintw(row_start + 9, col, "SP %X    DT %02X  ST %02X", chip8.sp, chip8.delay_timer, chip8.sound_timer);
+
+    mvprintw(row_start + 11, col, "stack:");
+    for (int i = 0; i < chip8.sp && i < 16; i ++) {
+        mvprintw(row_start + 12 + i % 8, col + (i / 8) * 10, "%X: %03X", i, chip8.stack[i]);
+    }
+
+    // 5 instructions either side of pc
+    for (int i = -5; i <= 5; i ++) {
+        int address = chip8.pc + 2 * i;
+        if (address < 0 || address + 1 >= 4096) continue;
+        uint16_t op = (chip8.memory[address] << 8) | chip8.memory[address + 1];
+        mvprintw(row_start + 26 + i, col, "%c%c%03X  %04X  %s",
+                 (i == 0) ? '>' : ' ', debugger.IsBreakpoint(address) ? '*' : ' ',
+                 address, op, Disassemble(op, chip8.quirks).c_str());
+    }
+    move(LINES - 1, 0);
+    refresh();
+}
+
+// debugger key (F5 / F9 / F10) seen by CatchInput(), ERR if none
+int Platform::DebugKey() {
+    int key = debug_key;
+    debug_key = ERR;
+    return key;
+}
+
 void Platform::ErrorMessage(const char* message) {
+    input.reset(); // getch() reads the keyboard again
     timeout(-1);
     erase();
     mvprintw(row_start, col_start, message);
@@ -130,134 +272,60 @@ void Platform::ErrorMessage(const std::string message) {
     ErrorMessage(message.c_str());
 }
 
-bool Platform::CatchInput(uint8_t (&keypad)[16]) {
-    int key = getch();
-
-    if (key != KEY_ESC) {
-        switch (key) {
-            case 'x':
-            case 'X':
-                keypad[last_key] = 0;
-                keypad[0x0] = 1;
-                last_key = 0x0;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case '1':
-                keypad[last_key] = 0;
-                keypad[0x1] = 1;
-                last_key = 0x1;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case '2':
-                keypad[last_key] = 0;
-                keypad[0x2] = 1;
-                last_key = 0x2;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case '3':
-                keypad[last_key] = 0;
-                keypad[0x3] = 1;
-                last_key = 0x3;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'q':
-            case 'Q':
-                keypad[last_key] = 0;
-                keypad[0x4] = 1;
-                last_key = 0x4;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'w':
-            case 'W':
-                keypad[last_key] = 0;
-                keypad[0x5] = 1;
-                last_key = 0x5;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'e':
-            case 'E':
-                keypad[last_key] = 0;
-                keypad[0x6] = 1;
-                last_key = 0x6;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'a':
-            case 'A':
-                keypad[last_key] = 0;
-                keypad[0x7] = 1;
-                last_key = 0x7;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 's':
-            case 'S':
-                keypad[last_key] = 0;
-                keypad[0x8] = 1;
-                last_key = 0x8;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'd':
-            case 'D':
-                keypad[last_key] = 0;
-                keypad[0x9] = 1;
-                last_key = 0x9;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'z':
-            case 'Z':
-                keypad[last_key] = 0;
-                keypad[0xA] = 1;
-                last_key = 0xA;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'c':
-            case 'C':
-                keypad[last_key] = 0;
-                keypad[0xB] = 1;
-                last_key = 0xB;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case '4':
-                keypad[last_key] = 0;
-                keypad[0xC] = 1;
-                last_key = 0xC;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'r':
-            case 'R':
-                keypad[last_key] = 0;
-                keypad[0xD] = 1;
-                last_key = 0xD;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'f':
-            case 'F':
-                keypad[last_key] = 0;
-                keypad[0xE] = 1;
-                last_key = 0xE;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-            case 'v':
-            case 'V':
-                keypad[last_key] = 0;
-                keypad[0xF] = 1;
-                last_key = 0xF;
-                last_keypress_time = std::chrono::high_resolution_clock::now();
-                break;
-
-            // other key or no key
-            default:
-                // hold keypad status for KEYPRESS_DURATION
-                auto current_time = std::chrono::high_resolution_clock::now();
-                double dt = std::chrono::duration<double, std::chrono::milliseconds::period>(current_time - last_keypress_time).count();
-                if (dt > KEYPRESS_DURATION) {
-                    keypad[last_key] = 0;
+// start the key event reader (kitty protocol / evdev / plain terminal),
+// from here on CatchInput() reads keys instead of getch()
+void Platform::StartInput(const char* evdev_path, bool &success) {
+    input.reset(new Input(stdout, evdev_path, success));
+    if (!success) input.reset();
+}
+
+bool Platform::CatchInput(uint8_t (&keypad)[16], int timeout) {
+    bool running = true;
+
+    events.clear();
+    if (input) input->Events(events, timeout);
+    auto now = std::chrono::steady_clock::now();
+    for (const KeyEvent &event : events) {
+        if (event.key <= 0xF) {
+            uint16_t bit = 1 << event.key;
+            if (event.type == KEY_EVENT_RELEASE) {
+                keys &= ~bit;
+            } else {
+                keys |= bit;
+                key_time[event.key] = event.time;
+                if (event.type == KEY_EVENT_PRESS && !input_pending) {
+                    input_pending = true;
+                    input_time = event.time;
                 }
-                break;
+            }
+            // arrival ==> keypad
+            stats.keypad_samples ++;
+            stats.keypad_time += std::chrono::duration<double>(now - event.time).count();
+            continue;
         }
 
-    // catch ESC
-    } else {
-        return false;
+        if (event.type == KEY_EVENT_RELEASE) continue;
+        if (event.key == INPUT_ESC) {
+            running = false;
+        } else if (event.key == INPUT_TAB) {
+            hud_visible = !hud_visible;
+            hud_toggled = true;
+        } else if (event.key == INPUT_F(5) || event.key == INPUT_F(9) || event.key == INPUT_F(10)) {
+            debug_key = KEY_F(event.key - INPUT_F(0));
+        }
+    }
+
+    // plain terminal bytes have no releases: let a key go KEYPRESS_DURATION
+    // after it was last seen (each key on its own, so several can be held)
+    if (input && !input->Releases()) {
+        for (int key = 0; key <= 0xF; key ++) {
+            double dt = std::chrono::duration<double, std::chrono::milliseconds::period>(now - key_time[key]).count();
+            if (dt > KEYPRESS_DURATION) keys &= ~(1 << key);
+        }
+    }
+
+    for (int key = 0; key <= 0xF; key ++) {
+        keypad[key] = (keys >> key) & 1;
     }
-    return true;
+    return running;
 }
@@ -2,13 +2,24 @@
 #define __PLATFORM_H__
 
 #include "Chip8.h"
+#include "Debugger.h"
+#include "Input.h"
+#include "Metrics.h"
+#include "Preview.h"
 
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #define TIMEOUT 0             // timeout for catch keyboard input
-#define KEYPRESS_DURATION 100 // timeout for holding a keypress (ms)
+#define KEYPRESS_DURATION 100 // timeout for holding a keypress (ms), when no releases are reported
+#define PAUSED_TIMEOUT 50     // timeout for catch keyboard input (ms) while the debugger is paused
+
+// terminal cells of the screen, one character per 2x2 pixels of video
+const int SCREEN_WIDTH  = VIDEO_WIDTH  / 2;
+const int SCREEN_HEIGHT = VIDEO_HEIGHT / 2;
 
 
 class Platform {
@@ -18,22 +29,51 @@ class Platform {
 
     std::string SelectROM(const char* base_dir, bool &success);
 
+    // only rows that changed since the last call are redrawn
     void UpdateScreen(const uint32_t (&video)[VIDEO_HEIGHT][VIDEO_WIDTH]);
 
-    void DebugInfo(const int cycle_delay, const Chip8 &chip8);
+    // run_ahead: frames presented ahead, run_ahead_cost: extra CPU time per frame (us)
+    void DebugInfo(const int cycle_delay, const Chip8 &chip8,
+                   const int run_ahead = 0, const double run_ahead_cost = 0);
+
+    // registers, stack and disassembly around pc, left of the screen
+    void DebugPane(const Chip8 &chip8, const Debugger &debugger);
+
+    // performance overlay, toggled with TAB, redrawn only when `metrics` changed
+    void HUD(const Metrics &metrics, const bool changed);
 
-    // return false if an ESC is pressed
-    bool CatchInput(uint8_t (&keypad)[16]);
+    // start the key event reader (kitty protocol / evdev / plain terminal),
+    // from here on CatchInput() reads keys instead of getch()
+    void StartInput(const char* evdev_path, bool &success);
+    // return false if an ESC is pressed; waits up to `timeout` ms for a key
+    // when none has arrived (0: never blocks)
+    bool CatchInput(uint8_t (&keypad)[16], int timeout = 0);
+    // debugger key (F5 / F9 / F10) seen by CatchInput(), ERR if none
+    int DebugKey();
 
     void ErrorMessage(const char* message);
     void ErrorMessage(const std::string message);
 
+    FrameStats stats;
+
   private:
     long row_start;
     long col_start;
-    char last_key = 0;
-    std::chrono::high_resolution_clock::time_point last_keypress_time
-        = std::chrono::high_resolution_clock::now();
+    bool hud_visible = false;
+    bool hud_toggled = false;
+    int  debug_key = -1;        // ERR
+    bool input_pending = false; // a keypress has not been presented yet
+    std::chrono::steady_clock::time_point input_time;
+
+    std::unique_ptr<Input> input;
+    std::vector<KeyEvent>  events;
+    uint16_t keys = 0;          // bit k = key k held
+    std::chrono::steady_clock::time_point key_time[16]; // last press / repeat
+    std::string drawn[SCREEN_HEIGHT]; // screen rows on the terminal, empty = redraw
+    const char* const* quadrants;     // QUADRANTS_UTF8 or QUADRANTS_ASCII
+
+    // thumbnail of the highlighted ROM, a placeholder until it is rendered
+    void DrawPreview(const Preview* preview, long row, long col);
 };
 
 #endif // __PLATFORM_H__
@@ -0,0 +1,148 @@
+#include "Preview.h"
+
+#include "Hash.h"
+
+#include <algorithm> // std::find(), std::find_if()
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// pixels lit in a 4x4 block, rounded up to quarters ==> character
+static const char SHADES[] = " .:*#";
+
+
+PreviewPool::PreviewPool(int threads) {
+    for (int i = 0; i < threads; i ++) {
+        workers.emplace_back(&PreviewPool::Worker, this);
+    }
+}
+
+PreviewPool::~PreviewPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        for (auto &job : running) job->cancelled = true;
+    }
+    wakeup.notify_all();
+    for (std::thread &worker : workers) worker.join();
+}
+
+// previews wanted now, most important first; queued or running work
+// for any other ROM is cancelled
+void PreviewPool::Want(const std::vector<std::string> &paths) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto wanted = [&](const std::string &path) {
+        return std::find(paths.begin(), paths.end(), path) != paths.end();
+    };
+
+    // a job also renders every other path with the same ROM
+    std::set<uint64_t> wanted_hashes;
+    for (const std::string &path : paths) {
+        auto hash = hashes.find(path);
+        if (hash != hashes.end()) wanted_hashes.insert(hash->second);
+    }
+    for (auto &job : running) {
+        if (!wanted(job->path) && !(job->hashed && wanted_hashes.count(job->hash))) job->cancelled = true;
+    }
+
+    std::deque<std::shared_ptr<Job>> next;
+    for (const std::string &path : paths) {
+        auto hash = hashes.find(path);
+        if (hash != hashes.end() && cache.count(hash->second)) continue; // done
+        auto busy = std::find_if(running.begin(), running.end(),
+                [&](const std::shared_ptr<Job> &job) { return job->path == path && !job->cancelled; });
+        if (busy != running.end()) continue;
+
+        auto job = std::make_shared<Job>();
+        job->path = path;
+        next.push_back(job);
+    }
+    queue.swap(next); // anything not wanted any more is dropped here
+    wakeup.notify_all();
+}
+
+// finished preview of a ROM, nullptr while it is still being rendered
+std::shared_ptr<const Preview> PreviewPool::Get(const std::string &path) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto hash = hashes.find(path);
+    if (hash == hashes.end()) return nullptr;
+    auto preview = cache.find(hash->second);
+    return (preview == cache.end()) ? nullptr : preview->second;
+}
+
+void PreviewPool::Worker() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wakeup.wait(guard, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+
+        std::shared_ptr<Job> job = queue.front();
+        queue.pop_front();
+        running.push_back(job);
+        guard.unlock();
+
+        std::ifstream file(job->path, std::ios::binary);
+        std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        uint64_t hash = Fnv1a(rom.data(), rom.size());
+
+        // same ROM under another name: already rendered, or being rendered
+        // by another worker, which Get() then picks up when it is done
+        guard.lock();
+        bool shared = cache.count(hash) || rendering.count(hash);
+        job->hashed = true;
+        job->hash   = hash;
+        if (shared) {
+            hashes[job->path] = hash;
+            running.erase(std::find(running.begin(), running.end(), job));
+            continue;
+        }
+        rendering.insert(hash); // before Render(), so nobody starts it twice
+        guard.unlock();
+
+        std::shared_ptr<Preview> preview = Render(rom, *job);
+
+        guard.lock();
+        rendering.erase(hash);
+        running.erase(std::find(running.begin(), running.end(), job));
+        if (preview) {
+            hashes[job->path] = hash;
+            cache[hash] = preview;
+        }
+    }
+}
+
+// run one ROM headless, nullptr if cancelled
+// (no frames at all if it is empty or does not fit in memory)
+std::shared_ptr<Preview> PreviewPool::Render(const std::vector<uint8_t> &rom, const Job &job) {
+    auto preview = std::make_shared<Preview>();
+    std::unique_ptr<Chip8> chip8(new Chip8());
+    bool success = true;
+    chip8->Seed(0);
+    chip8->LoadROM(rom.data(), rom.size(), success);
+    if (!success || rom.empty()) return preview;
+
+    while (preview->frames < PREVIEW_FRAMES) {
+        for (int i = 0; i < PREVIEW_STEP && success; i ++) chip8->Cycle(success);
+        if (job.cancelled) return nullptr;
+
+        auto &frame = preview->frame[preview->frames ++];
+        for (int row = 0; row < PREVIEW_ROWS; row ++) {
+            for (int col = 0; col < PREVIEW_COLS; col ++) {
+                int lit = 0;
+                for (int dy = 0; dy < 4; dy ++) {
+                    for (int dx = 0; dx < 4; dx ++) {
+                        lit += (chip8->video[4 * row + dy][4 * col + dx] != 0);
+                    }
+                }
+                frame[row][col] = SHADES[(lit + 3) / 4];
+            }
+            frame[row][PREVIEW_COLS] = '\0';
+        }
+        if (!success) break; // invalid pc, keep the last screen
+    }
+    return preview;
+}
@@ -0,0 +1,67 @@
+#ifndef __PREVIEW_H__
+#define __PREVIEW_H__
+
+#include "Chip8.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int PREVIEW_COLS   = VIDEO_WIDTH  / 4; // one character per 4x4 pixels
+const int PREVIEW_ROWS   = VIDEO_HEIGHT / 4; // (2x2 lo-res pixels)
+const int PREVIEW_FRAMES = 16;  // snapshots per preview, played in a loop
+const int PREVIEW_STEP   = 150; // cycles between snapshots
+
+
+// A few seconds of a ROM run headless, as ASCII thumbnails
+struct Preview {
+    int  frames = 0; // fewer than PREVIEW_FRAMES if the ROM stopped early, 0 if unusable
+    char frame[PREVIEW_FRAMES][PREVIEW_ROWS][PREVIEW_COLS + 1];
+};
+
+// Renders previews on background threads, cached by ROM hash. Nothing here
+// blocks on emulation: Get() returns nullptr until a preview is done.
+class PreviewPool {
+  public:
+    PreviewPool(int threads);
+    ~PreviewPool();
+
+    // previews wanted now, most important first; queued or running work
+    // for any other ROM is cancelled
+    void Want(const std::vector<std::string> &paths);
+    // finished preview of a ROM, nullptr while it is still being rendered
+    std::shared_ptr<const Preview> Get(const std::string &path);
+
+  private:
+    struct Job {
+        std::string       path;
+        std::atomic<bool> cancelled{false};
+        bool              hashed = false; // `hash` is known (under `lock`)
+        uint64_t          hash   = 0;
+    };
+
+    std::mutex                          lock;
+    std::condition_variable             wakeup;
+    std::deque<std::shared_ptr<Job>>    queue;
+    std::vector<std::shared_ptr<Job>>   running;
+    std::map<std::string, uint64_t>     hashes; // path ==> ROM hash
+    std::map<uint64_t, std::shared_ptr<const Preview>> cache;
+    std::set<uint64_t>                  rendering; // ROM hashes a worker is rendering now
+    std::vector<std::thread>            workers;
+    bool                                stopping = false;
+
+    void Worker();
+    // run one ROM headless, nullptr if cancelled
+    // (no frames at all if it is empty or does not fit in memory)
+    std::shared_ptr<Preview> Render(const std::vector<uint8_t> &rom, const Job &job);
+};
+
+#endif // __PREVIEW_H__
@@ -0,0 +1,25 @@
+#ifndef __QUADRANTS_H__
+#define __QUADRANTS_H__
+
+#include <clocale>
+#include <cstring>    // strcmp()
+#include <langinfo.h> // nl_langinfo()
+
+// pixels lit in a 2x2 block (bit 0 top left, 1 top right, 2 bottom left,
+// 3 bottom right) ==> character; a lo-res pixel is always empty or full
+const char* const QUADRANTS_UTF8[16] = {
+    " ", "▘", "▝", "▀", "▖", "▌", "▞", "▛", "▗", "▚", "▐", "▜", "▄", "▙", "▟", "█"
+};
+// the same shapes for terminals without UTF-8
+const char* const QUADRANTS_ASCII[16] = {
+    " ", "'", "`", "\"", ",", "[", "/", "P", ".", "\\", "]", "7", "_", "L", "J", "#"
+};
+const int QUADRANT_MAX_BYTES = 3; // longest UTF-8 sequence above
+
+// table for the locale from the environment (sets LC_CTYPE)
+inline const char* const* Quadrants() {
+    setlocale(LC_CTYPE, "");
+    return (strcmp(nl_langinfo(CODESET), "UTF-8") == 0) ? QUADRANTS_UTF8 : QUADRANTS_ASCII;
+}
+
+#endif // __QUADRANTS_H__
@@ -0,0 +1,53 @@
+#ifndef __QUIRKS_H__
+#define __QUIRKS_H__
+
+#include <cstring> // strcmp()
+
+// Behaviours that differ between CHIP-8 interpreters (and so between ROMs)
+enum Quirks {
+    QUIRKS_DEFAULT,  // this emulator so far, CHIP-48 like
+    QUIRKS_COSMAC,   // original COSMAC VIP interpreter
+    QUIRKS_SCHIP,    // SUPER-CHIP 1.1
+    QUIRKS_XOCHIP,   // XO-CHIP / Octo
+    QUIRKS_COUNT
+};
+
+struct QuirksInfo {
+    const char* name;
+    bool shift_vy;    // 8xy6/8xyE shift Vy into Vx, instead of Vx in place
+    bool index_moves; // Fx55/Fx65 leave index at index + x + 1
+    bool wrap;        // Dxyn wraps sprites around the screen edge, instead of clipping
+    bool jump_vx;     // Bxnn jumps to Vx + xnn, instead of V0 + nnn
+};
+
+constexpr QuirksInfo QUIRKS[QUIRKS_COUNT] = {
+    // name       shift_vy  index_moves  wrap   jump_vx
+    { "default",  false,    false,       false, false },
+    { "cosmac",   true,     true,        false, false },
+    { "schip",    false,    false,       false, true  },
+    { "xochip",   true,     true,        true,  false },
+};
+
+// Compile-time view of one profile. The opcode handlers affected by a quirk
+// are templates on this, so every profile gets its own branch-free copy and
+// Chip8::SetQuirks() only swaps OPTable entries.
+template <Quirks P>
+struct QuirksPolicy {
+    static constexpr bool shift_vy    = QUIRKS[P].shift_vy;
+    static constexpr bool index_moves = QUIRKS[P].index_moves;
+    static constexpr bool wrap        = QUIRKS[P].wrap;
+    static constexpr bool jump_vx     = QUIRKS[P].jump_vx;
+};
+
+// profile by name ("cosmac", ...), false if unknown
+inline bool QuirksByName(const char* name, Quirks &quirks) {
+    for (int i = 0; i < QUIRKS_COUNT; i ++) {
+        if (strcmp(QUIRKS[i].name, name) == 0) {
+            quirks = (Quirks)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // __QUIRKS_H__
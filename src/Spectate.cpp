@@ -0,0 +1,191 @@
+#include "Spectate.h"
+
+#include <algorithm> // std::remove_if()
+#include <cerrno>
+#include <cstdint>
+#include <cstring> // memcmp(), strncpy()
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+
+// type(u8) size(u16) + bytes
+static std::string Message(uint8_t type, const std::string &bytes) {
+    std::string message;
+    message.reserve(3 + bytes.size());
+    message += (char)type;
+    message += (char)(bytes.size() >> 8);
+    message += (char)(bytes.size() & 0xFF);
+    return message + bytes;
+}
+
+// XOR of two frames as (skip, count, xor[count]) runs, empty if equal
+static std::string Delta(const uint8_t* from, const uint8_t* to) {
+    std::string delta;
+    size_t i = 0;
+    while (i < SPECTATE_FRAME_SIZE) {
+        size_t skip = 0;
+        while (i < SPECTATE_FRAME_SIZE && from[i] == to[i] && skip < 0xFF) { skip ++; i ++; }
+        size_t start = i;
+        while (i < SPECTATE_FRAME_SIZE && from[i] != to[i] && i - start < 0xFF) i ++;
+        if (i == start && i == SPECTATE_FRAME_SIZE) break; // unchanged to the end
+
+        delta += (char)skip;
+        delta += (char)(i - start);
+        for (size_t j = start; j < i; j ++) delta += (char)(from[j] ^ to[j]);
+    }
+    return delta;
+}
+
+// apply a keyframe / delta to `frame`, false if it is malformed
+bool ApplyMessage(uint8_t type, const uint8_t* bytes, size_t size, uint8_t (&frame)[SPECTATE_FRAME_SIZE]) {
+    if (type == SPECTATE_KEYFRAME) {
+        if (size != SPECTATE_FRAME_SIZE) return false;
+        memcpy(frame, bytes, size);
+        return true;
+    }
+    if (type != SPECTATE_DELTA) return false;
+
+    size_t at = 0;
+    size_t i  = 0;
+    while (i + 2 <= size) {
+        size_t skip  = bytes[i];
+        size_t count = bytes[i + 1];
+        i  += 2;
+        at += skip;
+        if (i + count > size || at + count > SPECTATE_FRAME_SIZE) return false;
+        for (size_t j = 0; j < count; j ++) frame[at ++] ^= bytes[i ++];
+    }
+    return i == size;
+}
+
+Spectators::~Spectators() {
+    for (Viewer &viewer : viewers) close(viewer.fd);
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+}
+
+// listen on a Unix domain socket at `path`
+void Spectators::Listen(const std::string path, bool &success) {
+    socket_path = path;
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        success = false;
+        return;
+    }
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socket_path.c_str()); // stale socket from an earlier run
+    if (listen_fd < 0
+            || bind(listen_fd, (sockaddr*)&address, sizeof(address)) != 0
+            || listen(listen_fd, 8) != 0) {
+        success = false;
+    }
+}
+
+// take waiting connections, true if there were any
+bool Spectators::Accept() {
+    bool accepted = false;
+    int fd;
+    while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        std::string header(SPECTATE_MAGIC, sizeof(SPECTATE_MAGIC));
+        header += (char)SPECTATE_VERSION;
+        header += (char)VIDEO_WIDTH;
+        header += (char)VIDEO_HEIGHT;
+        header += (char)0;
+        viewers.push_back({fd, header, true});
+        accepted = true;
+    }
+    return accepted;
+}
+
+// accept new viewers, then send the screen of `chip8` to everyone who is ready
+void Spectators::Publish(const Chip8 &chip8) {
+    if (listen_fd < 0) return;
+    Accept();
+    if (viewers.empty()) {
+        last_valid = false; // nothing to base deltas on once someone connects
+        return;
+    }
+
+    uint8_t frame[SPECTATE_FRAME_SIZE];
+    chip8.PackVideo(frame);
+    bool changed = !last_valid || memcmp(frame, last, sizeof(frame)) != 0;
+
+    // encoded once, shared by every viewer; without a valid `last` every
+    // viewer is new and gets a keyframe
+    std::string delta;
+    if (changed && last_valid) delta = Message(SPECTATE_DELTA, Delta(last, frame));
+    memcpy(last, frame, sizeof(frame));
+    last_valid = true;
+    Deliver(delta);
+}
+
+// accept new viewers and send what is waiting, between presented frames
+void Spectators::Poll(const Chip8 &chip8) {
+    if (listen_fd < 0) return;
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_poll) return;
+    next_poll = now + std::chrono::milliseconds(SPECTATE_POLL);
+
+    bool waiting = Accept();
+    for (const Viewer &viewer : viewers) waiting |= !viewer.pending.empty();
+    if (!waiting) return;
+
+    if (!last_valid) {
+        chip8.PackVideo(last);
+        last_valid = true;
+    }
+    Deliver(std::string());
+}
+
+// queue a keyframe of `last` for viewers that need one, `delta` (if not
+// empty) for the rest, and send as much as the sockets take
+void Spectators::Deliver(const std::string &delta) {
+    std::string keyframe;
+    for (Viewer &viewer : viewers) {
+        if (!Flush(viewer)) continue;
+        if (!viewer.pending.empty()) {
+            // still sending an older message: this frame is dropped for it
+            viewer.resync |= !delta.empty();
+            continue;
+        }
+        if (viewer.resync) {
+            if (keyframe.empty()) {
+                keyframe = Message(SPECTATE_KEYFRAME, std::string((const char*)last, sizeof(last)));
+            }
+            viewer.pending = keyframe;
+            viewer.resync  = false;
+        } else if (!delta.empty()) {
+            viewer.pending = delta;
+        }
+        Flush(viewer);
+    }
+
+    viewers.erase(std::remove_if(viewers.begin(), viewers.end(),
+            [](const Viewer &viewer) { return viewer.fd < 0; }), viewers.end());
+}
+
+// send as much of `pending` as the socket takes, false if it is gone
+bool Spectators::Flush(Viewer &viewer) {
+    if (viewer.fd < 0) return false;
+    while (!viewer.pending.empty()) {
+        ssize_t sent = send(viewer.fd, viewer.pending.data(), viewer.pending.size(),
+                            MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            close(viewer.fd); // viewer went away
+            viewer.fd = -1;
+            return false;
+        }
+        viewer.pending.erase(0, sent);
+    }
+    return true;
+}
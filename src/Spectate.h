@@ -0,0 +1,79 @@
+#ifndef __SPECTATE_H__
+#define __SPECTATE_H__
+
+#include "Chip8.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Spectator stream layout (Unix domain socket, one stream per viewer):
+ *
+ *   stream  := header message*
+ *   header  := "C8SP" version(u8) width(u8) height(u8) 0(u8)
+ *   message := type(u8) size(u16) bytes[size]
+ *
+ *   'K' keyframe: the whole frame, 1 bit per pixel, row-major,
+ *                 most significant bit = leftmost pixel
+ *   'D' delta:    (skip(u8) count(u8) xor[count])*, i.e. leave `skip`
+ *                 bytes of the frame as they are, then XOR the next `count`
+ *
+ * A viewer gets a keyframe first, then a delta per presented frame that
+ * changed anything. A viewer that cannot keep up misses frames and gets a
+ * keyframe again once it has caught up. Multi-byte fields are big-endian.
+ */
+const char     SPECTATE_MAGIC[4]   = {'C', '8', 'S', 'P'};
+const uint8_t  SPECTATE_VERSION    = 1;
+const size_t   SPECTATE_FRAME_SIZE = VIDEO_PACKED_SIZE; // as Chip8::PackVideo()
+const int      SPECTATE_POLL       = 100; // ms between Poll()s that touch the sockets
+
+const uint8_t  SPECTATE_KEYFRAME   = 'K';
+const uint8_t  SPECTATE_DELTA      = 'D';
+
+
+// apply a keyframe / delta to `frame`, false if it is malformed
+bool ApplyMessage(uint8_t type, const uint8_t* bytes, size_t size, uint8_t (&frame)[SPECTATE_FRAME_SIZE]);
+
+// Publishes presented frames to any number of viewers. Never blocks the
+// caller: sockets are non-blocking, and a viewer whose last message is
+// still not sent just misses frames.
+class Spectators {
+  public:
+    Spectators() = default;
+    ~Spectators();
+
+    // listen on a Unix domain socket at `path`
+    void Listen(const std::string path, bool &success);
+    // accept new viewers, then send the screen of `chip8` to everyone who
+    // is ready; cheap when nobody is watching
+    void Publish(const Chip8 &chip8);
+    // accept new viewers and send what is waiting, between presented frames
+    // (paused, slow cycle_delay); touches the sockets every SPECTATE_POLL ms
+    void Poll(const Chip8 &chip8);
+
+  private:
+    struct Viewer {
+        int         fd;
+        std::string pending;     // unsent rest of the last message
+        bool        resync;      // missed a frame, next message is a keyframe
+    };
+
+    int         listen_fd = -1;
+    std::string socket_path;
+    std::vector<Viewer> viewers;
+    uint8_t     last[SPECTATE_FRAME_SIZE] = {}; // frame the deltas are based on
+    bool        last_valid = false;             // ... kept up to date while anyone watches
+    std::chrono::steady_clock::time_point next_poll;
+
+    // take waiting connections, true if there were any
+    bool Accept();
+    // queue a keyframe of `last` for viewers that need one, `delta` (if
+    // not empty) for the rest, and send as much as the sockets take
+    void Deliver(const std::string &delta);
+    // send as much of `pending` as the socket takes, false if it is gone
+    bool Flush(Viewer &viewer);
+};
+
+#endif // __SPECTATE_H__
@@ -0,0 +1,277 @@
+#include "Trace.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // memcpy()
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+
+static void PutU32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static uint32_t GetU32(const uint8_t *in) {
+    return (in[0] << 24) | (in[1] << 16) | (in[2] << 8) | in[3];
+}
+
+
+TraceWriter::TraceWriter(const std::string filename, bool compress, bool &success)
+        : compress(compress) {
+    file = fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        success = false;
+        return;
+    }
+
+    uint8_t header[8] = {};
+    memcpy(header, TRACE_MAGIC, 4);
+    header[4] = TRACE_VERSION;
+    header[5] = compress ? TRACE_FLAG_COMPRESSED : 0;
+    fwrite(header, 1, sizeof(header), file);
+
+    // double buffer: one being filled, one being flushed
+    active.data.reset(new uint8_t[TRACE_CHUNK_SIZE]);
+    free_chunks.emplace_back();
+    free_chunks.back().data.reset(new uint8_t[TRACE_CHUNK_SIZE]);
+
+    flusher = std::thread(&TraceWriter::FlushLoop, this);
+}
+
+TraceWriter::~TraceWriter() {
+    if (file == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (active.used > 0) full_chunks.push_back(std::move(active));
+        stopping = true;
+    }
+    wake.notify_one();
+    flusher.join();
+    fclose(file);
+
+    if (dropped_chunks > 0) {
+        fprintf(stderr, "[WARNING] Trace fell behind: %llu of %llu instructions were not recorded "
+                        "(%llu chunks dropped, marked as gaps in the trace).\n",
+                (unsigned long long)lost_records, (unsigned long long)records,
+                (unsigned long long)dropped_chunks);
+    }
+}
+
+// hand the active chunk to the flush thread and pick up an empty one
+// never waits for I/O: if both buffers are busy a spare chunk is allocated,
+// and if the flush thread falls TRACE_MAX_BACKLOG chunks behind the chunk
+// is dropped (each chunk starts with a full state, so the rest still decodes,
+// and a gap record tells the reader how many instructions are missing)
+void TraceWriter::Rotate() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (full_chunks.size() >= TRACE_MAX_BACKLOG) {
+            dropped_chunks ++;
+            lost_records += chunk_records;
+            unreported   += chunk_records;
+            chunk_records = 0;
+            active.used   = 0;
+            keyframe      = true;
+            WriteGap();
+            return;
+        }
+        full_chunks.push_back(std::move(active));
+        unreported = 0; // its gap record, if any, is on the way
+        if (!free_chunks.empty()) {
+            active = std::move(free_chunks.back());
+            free_chunks.pop_back();
+        } else {
+            active = Chunk();
+        }
+    }
+    wake.notify_one();
+
+    if (!active.data) {
+        active.data.reset(new uint8_t[TRACE_CHUNK_SIZE]);
+        spare_chunks ++;
+    }
+    active.used   = 0;
+    chunk_records = 0;
+    keyframe      = true; // chunks are decodable on their own
+}
+
+// start `active` with a gap record for `unreported`
+void TraceWriter::WriteGap() {
+    uint8_t *out = active.data.get();
+    out[0] = TRACE_GAP;
+    PutU32(out + 1, unreported > UINT32_MAX ? UINT32_MAX : unreported);
+    active.used = 5;
+}
+
+// body of the flush thread
+void TraceWriter::FlushLoop() {
+    std::vector<uint8_t> zbuf;
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true) {
+        wake.wait(guard, [this] { return stopping || !full_chunks.empty(); });
+        if (full_chunks.empty()) break; // stopping and drained
+
+        Chunk chunk = std::move(full_chunks.front());
+        full_chunks.pop_front();
+
+        guard.unlock();
+        WriteChunk(chunk, zbuf);
+        guard.lock();
+
+        chunk.used = 0;
+        free_chunks.push_back(std::move(chunk));
+    }
+    fflush(file);
+}
+
+void TraceWriter::WriteChunk(const Chunk &chunk, std::vector<uint8_t> &zbuf) {
+    const uint8_t *payload = chunk.data.get();
+    uLongf stored_size = chunk.used;
+
+    if (compress) {
+        zbuf.resize(compressBound(chunk.used));
+        uLongf zsize = zbuf.size();
+        // only keep the compressed bytes if they are actually smaller
+        if (compress2(zbuf.data(), &zsize, payload, chunk.used, Z_BEST_SPEED) == Z_OK
+                && zsize < chunk.used) {
+            payload = zbuf.data();
+            stored_size = zsize;
+        }
+    }
+
+    uint8_t header[8];
+    PutU32(header,     chunk.used);
+    PutU32(header + 4, stored_size);
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(payload, 1, stored_size, file);
+    bytes_written += sizeof(header) + stored_size;
+}
+
+
+TraceReader::TraceReader(const std::string filename, bool &success) {
+    file = fopen(filename.c_str(), "rb");
+    if (file == nullptr) {
+        success = false;
+        return;
+    }
+
+    uint8_t header[8];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header)
+            || memcmp(header, TRACE_MAGIC, 4) != 0
+            || header[4] < 1 || header[4] > TRACE_VERSION) {
+        success = false;
+    }
+}
+
+TraceReader::~TraceReader() {
+    if (file != nullptr) fclose(file);
+}
+
+bool TraceReader::ReadChunk() {
+    uint8_t header[8];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header)) return false;
+
+    uint32_t raw_size    = GetU32(header);
+    uint32_t stored_size = GetU32(header + 4);
+    if (raw_size > TRACE_CHUNK_SIZE || stored_size > raw_size) {
+        corrupt = true;
+        return false;
+    }
+
+    std::vector<uint8_t> stored(stored_size);
+    if (fread(stored.data(), 1, stored_size, file) != stored_size) {
+        corrupt = true;
+        return false;
+    }
+
+    if (stored_size == raw_size) {
+        chunk.swap(stored);
+    } else {
+        chunk.resize(raw_size);
+        uLongf size = raw_size;
+        if (uncompress(chunk.data(), &size, stored.data(), stored_size) != Z_OK
+                || size != raw_size) {
+            corrupt = true;
+            return false;
+        }
+    }
+    pos = 0;
+    return true;
+}
+
+// decode the next record, return false at end of trace or on a corrupt chunk
+bool TraceReader::Next(TraceState &state) {
+    while (pos >= chunk.size()) {
+        if (!ReadChunk()) return false;
+    }
+
+    const uint8_t *in  = chunk.data() + pos;
+    const uint8_t *end = chunk.data() + chunk.size();
+    if (end - in < 3) {
+        corrupt = true;
+        return false;
+    }
+
+    uint8_t tag = *in ++;
+    if (tag & TRACE_GAP) {
+        if (end - in < 4) {
+            corrupt = true;
+            return false;
+        }
+        lost          += GetU32(in);
+        next_position += GetU32(in);
+        pos = in + 4 - chunk.data();
+        return Next(state);
+    }
+    last.opcode = (in[0] << 8) | in[1];
+    in += 2;
+
+    size_t need = ((tag & TRACE_PC)    ? 2 : 0)
+                + ((tag & TRACE_INDEX) ? 2 : 0)
+                + ((tag & TRACE_SP)    ? 1 : 0)
+                + ((tag & TRACE_REGS)  ? 2 : 0);
+    if ((size_t)(end - in) < need) {
+        corrupt = true;
+        return false;
+    }
+
+    if (tag & TRACE_PC) {
+        last.pc = (in[0] << 8) | in[1];
+        in += 2;
+    } else {
+        last.pc += 2;
+    }
+    if (tag & TRACE_INDEX) {
+        last.index = (in[0] << 8) | in[1];
+        in += 2;
+    }
+    if (tag & TRACE_SP) {
+        last.sp = *in ++;
+    }
+    if (tag & TRACE_REGS) {
+        uint16_t mask = (in[0] << 8) | in[1];
+        in += 2;
+        for (uint8_t i = 0; i < 16; i ++) {
+            if (mask & (0x8000 >> i)) {
+                if (in >= end) {
+                    corrupt = true;
+                    return false;
+                }
+                last.registers[i] = *in ++;
+            }
+        }
+    }
+
+    pos = in - chunk.data();
+    state = last;
+    position = next_position ++;
+    return true;
+}
@@ -0,0 +1,193 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Execution trace file layout:
+ *
+ *   file   := header chunk*
+ *   header := "C8TR" version(u8) flags(u8) 0(u16)
+ *   chunk  := raw_size(u32) stored_size(u32) bytes[stored_size]
+ *             (stored_size < raw_size ==> bytes are zlib-compressed)
+ *
+ * A chunk holds delta-encoded records, one per executed instruction:
+ *
+ *   record := tag(u8) opcode(u16)
+ *             [pc(u16)]            if TRACE_PC
+ *             [index(u16)]         if TRACE_INDEX
+ *             [sp(u8)]             if TRACE_SP
+ *             [mask(u16) Vn(u8)*]  if TRACE_REGS, one byte per set bit
+ *           | TRACE_GAP(u8) lost(u32)
+ *
+ * pc defaults to "previous pc + 2", everything else to "unchanged since the
+ * previous record". The first record of every chunk carries the full state,
+ * so chunks can be decoded independently. When the writer had to drop
+ * chunks, the next chunk starts with a gap record: `lost` instructions
+ * were executed but not recorded. Multi-byte fields are big-endian.
+ */
+const char     TRACE_MAGIC[4]        = {'C', '8', 'T', 'R'};
+const uint8_t  TRACE_VERSION         = 2; // 1: no gap records
+const uint8_t  TRACE_FLAG_COMPRESSED = 0x01;
+
+const uint8_t  TRACE_PC              = 0x01;
+const uint8_t  TRACE_INDEX           = 0x02;
+const uint8_t  TRACE_SP              = 0x04;
+const uint8_t  TRACE_REGS            = 0x08;
+const uint8_t  TRACE_GAP             = 0x80;
+
+const size_t   TRACE_CHUNK_SIZE      = 64 * 1024;
+const size_t   TRACE_MAX_RECORD      = 1 + 2 + 2 + 2 + 1 + 2 + 16;
+const size_t   TRACE_MAX_BACKLOG     = 64; // chunks queued before new ones are dropped
+
+class Chip8;
+
+
+// State seen by the trace after one instruction
+struct TraceState {
+    uint16_t pc;
+    uint16_t opcode;
+    uint16_t index;
+    uint8_t  sp;
+    uint8_t  registers[16];
+};
+
+class TraceWriter {
+  public:
+    // open `filename` and start the flush thread
+    TraceWriter(const std::string filename, bool compress, bool &success);
+    // flush what is left and join the flush thread, then report any
+    // dropped chunks on stderr
+    ~TraceWriter();
+
+    // append one executed instruction, called from Chip8::Cycle()
+    // op_pc: address the instruction was fetched from
+    inline void Record(const Chip8 &chip8, uint16_t op_pc);
+
+    uint64_t              records        = 0; // instructions recorded
+    std::atomic<uint64_t> bytes_written  {0}; // bytes handed to the file (after compression)
+    uint64_t              spare_chunks   = 0; // chunks allocated because both buffers were busy
+    uint64_t              dropped_chunks = 0; // chunks discarded because the backlog was full
+    uint64_t              lost_records   = 0; // instructions in those chunks
+
+  private:
+    struct Chunk {
+        std::unique_ptr<uint8_t[]> data;
+        size_t                     used = 0;
+    };
+
+    FILE*                   file;
+    bool                    compress;
+
+    Chunk                   active;          // being filled by the emulation thread
+    std::vector<Chunk>      free_chunks;     // flushed, ready for reuse
+    std::deque<Chunk>       full_chunks;     // waiting for the flush thread
+    std::mutex              lock;
+    std::condition_variable wake;
+    bool                    stopping = false;
+    std::thread             flusher;
+
+    bool                    keyframe = true; // next record carries the full state
+    uint64_t                chunk_records = 0; // records in `active`
+    uint64_t                unreported    = 0; // lost records no queued chunk has a gap record for
+    uint16_t                last_pc;
+    uint16_t                last_index;
+    uint8_t                 last_sp;
+    uint8_t                 last_registers[16];
+
+    // hand the active chunk to the flush thread and pick up an empty one
+    void Rotate();
+    // start `active` with a gap record for `unreported`
+    void WriteGap();
+    // body of the flush thread
+    void FlushLoop();
+    void WriteChunk(const Chunk &chunk, std::vector<uint8_t> &zbuf);
+};
+
+class TraceReader {
+  public:
+    TraceReader(const std::string filename, bool &success);
+    ~TraceReader();
+
+    // decode the next record, return false at end of trace or on a corrupt chunk
+    bool Next(TraceState &state);
+
+    bool     corrupt  = false;
+    uint64_t position = 0; // of the record Next() returned, counting lost ones
+    uint64_t lost     = 0; // records the writer dropped, up to here
+
+  private:
+    FILE*                file;
+    std::vector<uint8_t> chunk;
+    size_t               pos = 0;
+    TraceState           last = {};
+    uint64_t             next_position = 0;
+
+    bool ReadChunk();
+};
+
+
+#include "Chip8.h"
+
+inline void TraceWriter::Record(const Chip8 &chip8, uint16_t op_pc) {
+    if (active.used + TRACE_MAX_RECORD > TRACE_CHUNK_SIZE) Rotate();
+
+    uint8_t *out = active.data.get() + active.used;
+    uint8_t *tag = out ++;
+    *out ++ = chip8.opcode >> 8;
+    *out ++ = chip8.opcode & 0xFF;
+    *tag = 0;
+
+    if (keyframe || op_pc != (uint16_t)(last_pc + 2)) {
+        *tag |= TRACE_PC;
+        *out ++ = op_pc >> 8;
+        *out ++ = op_pc & 0xFF;
+    }
+    if (keyframe || chip8.index != last_index) {
+        *tag |= TRACE_INDEX;
+        *out ++ = chip8.index >> 8;
+        *out ++ = chip8.index & 0xFF;
+    }
+    if (keyframe || chip8.sp != last_sp) {
+        *tag |= TRACE_SP;
+        *out ++ = chip8.sp;
+    }
+    uint64_t now[2], before[2];
+    memcpy(now,    chip8.registers, 16);
+    memcpy(before, last_registers,  16);
+    if (keyframe || now[0] != before[0] || now[1] != before[1]) {
+        *tag |= TRACE_REGS;
+        uint8_t *mask = out;
+        out += 2;
+        uint16_t bits = 0;
+        for (uint8_t i = 0; i < 16; i ++) {
+            if (keyframe || chip8.registers[i] != last_registers[i]) {
+                bits |= 0x8000 >> i;
+                *out ++ = chip8.registers[i];
+            }
+        }
+        mask[0] = bits >> 8;
+        mask[1] = bits & 0xFF;
+        memcpy(last_registers, chip8.registers, 16);
+    }
+
+    last_pc    = op_pc;
+    last_index = chip8.index;
+    last_sp    = chip8.sp;
+    keyframe   = false;
+
+    active.used = out - active.data.get();
+    chunk_records ++;
+    records ++;
+}
+
+#endif // __TRACE_H__
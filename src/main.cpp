@@ -1,28 +1,87 @@
 #include "Chip8.h"
+#include "Debugger.h"
+#include "Metrics.h"
 #include "Platform.h"
+#include "Spectate.h"
+#include "Trace.h"
 
 #include <chrono>
+#include <cstring> // strcmp()
+#include <memory>
 #include <ncurses.h>
 #include <stdexcept>
 #include <string>
 
+#define MAX_RUN_AHEAD 60 // frames
+
 
 int main(int argc, char** argv) {
     bool success = true;
     int cycle_delay = 3;
+    const char* trace_filename = nullptr;
+    bool trace_compress = false;
+    int run_ahead = 0;
+    const char* metrics_target = nullptr;
+    const char* quirks_name = nullptr;
+    const char* evdev_path = nullptr;
+    const char* spectate_path = nullptr;
+    Debugger debugger;
 
-    if (argc == 2) {
-        try {
-            cycle_delay = std::stoi(argv[1]);
-        } catch (std::invalid_argument const& ex) {
-            printf("Invalid delay '%s'.\nExiting...\n", argv[1]);
-            return 1;
+    for (int i = 1; i < argc; i ++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_filename = argv[++ i];
+        } else if (strcmp(argv[i], "--trace-compress") == 0) {
+            trace_compress = true;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_target = argv[++ i];
+        } else if (strcmp(argv[i], "--break") == 0 && i + 1 < argc) {
+            debugger.AddBreakpoint(argv[++ i], success);
+            if (!success) {
+                printf("Invalid breakpoint '%s' (i.e. 2A0, 2A0,V3==1F or V3>=10).\nExiting...\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            debugger.AddWatchpoint(argv[++ i], success);
+            if (!success) {
+                printf("Invalid watchpoint '%s' (i.e. 300-30F, 300:w or 300-3FF:r).\nExiting...\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            spectate_path = argv[++ i];
+        } else if (strcmp(argv[i], "--evdev") == 0 && i + 1 < argc) {
+            evdev_path = argv[++ i];
+        } else if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc) {
+            quirks_name = argv[++ i];
+        } else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc) {
+            try {
+                run_ahead = std::stoi(argv[++ i]);
+            } catch (std::invalid_argument const& ex) {
+                printf("Invalid run-ahead '%s'.\nExiting...\n", argv[i]);
+                return 1;
+            }
+            if (run_ahead < 0) run_ahead = 0;
+            if (run_ahead > MAX_RUN_AHEAD) run_ahead = MAX_RUN_AHEAD;
+        } else {
+            try {
+                cycle_delay = std::stoi(argv[i]);
+            } catch (std::invalid_argument const& ex) {
+                printf("Invalid delay '%s'.\nExiting...\n", argv[i]);
+                return 1;
+            }
+            if (cycle_delay < 2) cycle_delay = 2;
+            if (cycle_delay > 5000) cycle_delay = 5000;
         }
-        if (cycle_delay < 2) cycle_delay = 2;
-        if (cycle_delay > 5000) cycle_delay = 5000;
     }
 
-    Platform platform(VIDEO_WIDTH, VIDEO_HEIGHT, success);
+    Quirks quirks = QUIRKS_DEFAULT;
+    if (quirks_name != nullptr && !QuirksByName(quirks_name, quirks)) {
+        printf("Invalid quirks '%s' (default, cosmac, schip or xochip).\nExiting...\n", quirks_name);
+        return 1;
+    }
+
+    // outlives the screen, so a warning about dropped trace chunks is seen
+    std::unique_ptr<TraceWriter> tracer;
+    Platform platform(SCREEN_WIDTH, SCREEN_HEIGHT, success);
     if (!success) return 1;
 
     std::string rom_filename = platform.SelectROM("rom", success);
@@ -35,26 +94,137 @@ int main(int argc, char** argv) {
         platform.ErrorMessage(msg);
         return 1;
     }
+    chip8.SetQuirks(quirks); // --quirks, or QUIRKS_DEFAULT
+
+    if (trace_filename != nullptr) {
+        tracer.reset(new TraceWriter(trace_filename, trace_compress, success));
+        if (!success) {
+            std::string msg = "[ERROR] Failed to open trace file '" + std::string(trace_filename) + "'.";
+            platform.ErrorMessage(msg);
+            return 1;
+        }
+        chip8.tracer = tracer.get();
+    }
+
+    Metrics metrics;
+    if (metrics_target != nullptr) {
+        metrics.Export(metrics_target, success);
+        if (!success) {
+            std::string msg = "[ERROR] Failed to export metrics to '" + std::string(metrics_target) + "'.";
+            platform.ErrorMessage(msg);
+            return 1;
+        }
+    }
+
+    Spectators spectators;
+    if (spectate_path != nullptr) {
+        spectators.Listen(spectate_path, success);
+        if (!success) {
+            std::string msg = "[ERROR] Failed to listen for spectators on '" + std::string(spectate_path) + "'.";
+            platform.ErrorMessage(msg);
+            return 1;
+        }
+    }
+
+    platform.StartInput(evdev_path, success);
+    if (!success) {
+        std::string msg = (evdev_path != nullptr)
+            ? "[ERROR] Failed to open input device '" + std::string(evdev_path) + "'."
+            : "[ERROR] Failed to start keyboard input.";
+        platform.ErrorMessage(msg);
+        return 1;
+    }
 
     if (success) {
         auto last_cycle_time = std::chrono::high_resolution_clock::now();
+        Chip8State snapshot;
+        double run_ahead_cost = 0; // us per frame, smoothed
+        uint64_t instructions = 0;
 
-        while (platform.CatchInput(chip8.keypad)) {
+        // nothing runs while the debugger is paused: sleep until a key arrives
+        while (platform.CatchInput(chip8.keypad, debugger.paused ? PAUSED_TIMEOUT : 0)) {
             auto current_time = std::chrono::high_resolution_clock::now();
             double dt = std::chrono::duration<double, std::chrono::milliseconds::period>(current_time - last_cycle_time).count();
 
-            if (dt > cycle_delay) {
+            if (dt > cycle_delay && !debugger.paused) {
                 last_cycle_time = current_time;
-                chip8.Cycle(success);
+                // the checked path only while breakpoints/watchpoints are set
+                bool ran = true;
+                if (debugger.Armed()) {
+                    ran = debugger.Cycle(chip8, success);
+                } else {
+                    chip8.Cycle(success);
+                }
                 if (!success) {
                     platform.ErrorMessage("[ERROR] Invalid pc value in runtime.");
                     return 1;
                 }
-                platform.UpdateScreen(chip8.video);
+                if (!ran) {
+                    platform.DebugPane(chip8, debugger); // stopped before a hit
+                    continue;
+                }
+                instructions ++;
+
+                if (run_ahead > 0) {
+                    // present the frame `run_ahead` cycles in the future with
+                    // the current input, then roll back to the real timeline
+                    auto ahead_start = std::chrono::high_resolution_clock::now();
+                    TraceWriter* real_tracer = chip8.tracer;
+                    chip8.tracer = nullptr;
+                    chip8.SaveState(snapshot);
+
+                    bool ahead_success = true;
+                    for (int i = 0; i < run_ahead && ahead_success; i ++) {
+                        chip8.Cycle(ahead_success);
+                    }
+                    auto ahead_end = std::chrono::high_resolution_clock::now();
+                    platform.UpdateScreen(chip8.video);
+                    spectators.Publish(chip8);
+
+                    auto restore_start = std::chrono::high_resolution_clock::now();
+                    chip8.LoadState(snapshot);
+                    chip8.tracer = real_tracer;
+                    auto restore_end = std::chrono::high_resolution_clock::now();
+
+                    double cost = std::chrono::duration<double, std::chrono::microseconds::period>(
+                            (ahead_end - ahead_start) + (restore_end - restore_start)).count();
+                    run_ahead_cost = 0.9 * run_ahead_cost + 0.1 * cost;
+                } else {
+                    platform.UpdateScreen(chip8.video);
+                    spectators.Publish(chip8);
+                }
                 #ifdef DEBUG
-                    platform.DebugInfo(cycle_delay, chip8);
+                    platform.DebugInfo(cycle_delay, chip8, run_ahead, run_ahead_cost);
+                    platform.DebugPane(chip8, debugger);
                 #endif
             }
+
+            // F5 run/pause, F9 toggle a breakpoint at pc, F10 single step
+            int debug_key = platform.DebugKey();
+            if (debug_key != ERR) {
+                if (debug_key == KEY_F(9)) {
+                    debugger.ToggleBreakpoint(chip8.pc);
+                } else if (debug_key == KEY_F(5) && !debugger.paused) {
+                    debugger.paused = true;
+                    debugger.reason = "paused";
+                } else if (debugger.paused) {
+                    // the instruction it stopped on runs without hitting again
+                    debugger.Step(chip8, success);
+                    if (!success) {
+                        platform.ErrorMessage("[ERROR] Invalid pc value in runtime.");
+                        return 1;
+                    }
+                    instructions ++;
+                    debugger.paused = (debug_key == KEY_F(10));
+                    debugger.reason = "single step";
+                    platform.UpdateScreen(chip8.video);
+                    spectators.Publish(chip8);
+                }
+                platform.DebugPane(chip8, debugger);
+            }
+
+            platform.HUD(metrics, metrics.Update(instructions, platform.stats));
+            spectators.Poll(chip8); // viewers that connect while nothing is presented
         }
     }
 
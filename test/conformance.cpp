@@ -0,0 +1,375 @@
+// Conformance and throughput gate behind `make test`.
+//
+// Every run of the spec file (test/conformance.txt, format described there)
+// loads a ROM on a headless Chip8 with a fixed seed, replays the scripted
+// keypad and compares the hash of `video` at the chosen frames with the
+// golden values. The replays are spread over one thread per core; then
+// each instance is timed on its own, one after the other, so no timing
+// shares the CPU with another. The suite fails if any run, or the
+// geometric mean of all runs, is more than --tolerance percent below this
+// machine's recorded instructions/sec. A run without a recorded speed is
+// recorded now (with a warning) and gated from the next time on.
+//
+//   chip8_test [--update] [--record] [--tolerance PCT] [--baseline FILE] <spec>
+//
+//   --update    write the hashes seen now into the spec (after an intended change)
+//   --record    write the speeds measured now as this machine's baseline
+//               (after a confirmed change in speed, or on a new machine)
+
+#include "../src/Chip8.h"
+
+#include <algorithm> // std::max(), std::min()
+#include <atomic>
+#include <chrono>
+#include <cmath>   // std::log(), std::exp()
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // strcmp()
+#include <iomanip> // std::setw(), std::setfill()
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+const uint64_t PERF_CYCLES  = 2000000; // timed cycles per repetition
+const int      PERF_REPEATS = 7;       // best one counts, the others absorb noise
+
+// one frame = one Cycle(), as the emulator presents the screen after each
+struct KeyChange {
+    uint64_t frame;
+    uint16_t keys;   // bit k = key k held, from this frame on
+};
+
+struct Check {
+    uint64_t frame;
+    uint64_t hash;
+    bool     known;  // the spec has a golden value
+    size_t   line;   // spec line, for --update
+    uint64_t got = 0;
+};
+
+struct Run {
+    std::string            rom;
+    uint32_t               seed = 0;
+    std::string            quirks;
+    std::vector<KeyChange> keys;
+    std::vector<Check>     checks;
+
+    // results
+    Chip8                  chip8;  // where the script left the ROM, timed from there
+    std::string            error;
+    double                 instructions_per_sec = 0;
+};
+
+
+static void SetKeys(Chip8 &chip8, uint16_t keys) {
+    for (int k = 0; k < 16; k ++) chip8.keypad[k] = (keys >> k) & 1;
+}
+
+// spec lines ==> runs, false (and `error`) on a malformed line
+static bool ParseSpec(const std::vector<std::string> &lines, std::vector<Run> &runs, std::string &error) {
+    for (size_t i = 0; i < lines.size(); i ++) {
+        std::istringstream line(lines[i]);
+        std::string word;
+        if (!(line >> word) || word[0] == '#') continue;
+
+        bool valid = true;
+        if (word == "rom") {
+            runs.emplace_back();
+            std::getline(line >> std::ws, runs.back().rom);
+            valid = !runs.back().rom.empty();
+        } else if (runs.empty()) {
+            valid = false;
+        } else if (word == "seed") {
+            valid = bool(line >> runs.back().seed);
+        } else if (word == "quirks") {
+            Quirks quirks;
+            valid = (line >> runs.back().quirks) && QuirksByName(runs.back().quirks.c_str(), quirks);
+        } else if (word == "keys") {
+            KeyChange change;
+            valid = bool(line >> change.frame >> std::hex >> change.keys);
+            if (valid) runs.back().keys.push_back(change);
+        } else if (word == "check") {
+            Check check = { 0, 0, false, i };
+            valid = bool(line >> check.frame);
+            check.known = bool(line >> std::hex >> check.hash);
+            if (valid) runs.back().checks.push_back(check);
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            error = "line " + std::to_string(i + 1) + ": " + lines[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+// load the ROM and replay the script up to the last golden frame
+static void Replay(Run &run, const std::string &rom_dir) {
+    bool success = true;
+    Chip8 &chip8 = run.chip8;
+    chip8.Seed(run.seed);
+    chip8.LoadROM(rom_dir + run.rom, success);
+    if (!success) {
+        run.error = "cannot load ROM";
+        return;
+    }
+    if (!run.quirks.empty()) {
+        Quirks quirks = QUIRKS_DEFAULT;
+        QuirksByName(run.quirks.c_str(), quirks);
+        chip8.SetQuirks(quirks);
+    }
+
+    // golden frames
+    uint64_t last = 0;
+    for (const Check &check : run.checks) last = std::max(last, check.frame);
+    for (uint64_t frame = 0; frame <= last; frame ++) {
+        for (const KeyChange &change : run.keys) {
+            if (change.frame == frame) SetKeys(chip8, change.keys);
+        }
+        for (Check &check : run.checks) {
+            if (check.frame == frame) check.got = chip8.VideoHash();
+        }
+        if (frame == last) break;
+        chip8.Cycle(success);
+        if (!success) {
+            run.error = "invalid pc at frame " + std::to_string(frame);
+            return;
+        }
+    }
+}
+
+// throughput, from wherever Replay() left the ROM
+// (one repetition, the best one is kept)
+static void Time(Run &run) {
+    bool success = true;
+    Chip8 &chip8 = run.chip8;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < PERF_CYCLES && success; i ++) chip8.Cycle(success);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!success) {
+        run.error = "invalid pc while timing";
+        return;
+    }
+    run.instructions_per_sec = std::max(run.instructions_per_sec, PERF_CYCLES / seconds);
+}
+
+// name of a run in the baseline: everything that decides what gets timed,
+// i.e. "<seed> <quirks> <keys> @<last frame> <rom>", keys as frame:hex,...
+static std::string RunName(const Run &run) {
+    std::ostringstream name;
+    name << run.seed << " " << (run.quirks.empty() ? "default" : run.quirks) << " ";
+    for (size_t i = 0; i < run.keys.size(); i ++) {
+        name << (i ? "," : "") << std::dec << run.keys[i].frame << ":"
+             << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << run.keys[i].keys;
+    }
+    if (run.keys.empty()) name << "-";
+    uint64_t last = 0;
+    for (const Check &check : run.checks) last = std::max(last, check.frame);
+    name << std::dec << " @" << last << " " << run.rom;
+    return name.str();
+}
+
+// "<instructions/sec> <run name>" per line
+static std::map<std::string, double> ReadBaseline(const std::string &path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        double speed;
+        std::string name;
+        if (line.empty() || line[0] == '#' || !(fields >> speed)) continue;
+        std::getline(fields >> std::ws, name);
+        baseline[name] = speed;
+    }
+    return baseline;
+}
+
+static bool WriteLines(const std::string &path, const std::vector<std::string> &lines) {
+    std::ofstream file(path);
+    for (const std::string &line : lines) file << line << "\n";
+    return bool(file);
+}
+
+int main(int argc, char** argv) {
+    bool update = false;
+    bool record = false;
+    double tolerance = 20;
+    std::string spec_path;
+    std::string baseline_path;
+
+    for (int i = 1; i < argc; i ++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (strcmp(argv[i], "--record") == 0) {
+            record = true;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            try {
+                tolerance = std::stod(argv[++ i]);
+            } catch (std::logic_error const& ex) {
+                tolerance = -1;
+            }
+            if (tolerance < 0 || tolerance > 100) {
+                printf("Invalid tolerance '%s' (percent, 0 ~ 100).\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++ i];
+        } else if (spec_path.empty() && argv[i][0] != '-') {
+            spec_path = argv[i];
+        } else {
+            printf("Usage: %s [--update] [--record] [--tolerance PCT] [--baseline FILE] <spec>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (spec_path.empty()) {
+        printf("Usage: %s [--update] [--record] [--tolerance PCT] [--baseline FILE] <spec>\n", argv[0]);
+        return 1;
+    }
+
+    // spec next to the ROMs' parent: test/conformance.txt ==> rom/...
+    std::string spec_dir = spec_path.substr(0, spec_path.find_last_of('/') + 1);
+    std::string rom_dir  = spec_dir + "../rom/";
+    if (baseline_path.empty()) {
+        char host[256] = "unknown";
+        gethostname(host, sizeof(host) - 1);
+        mkdir((spec_dir + "baselines").c_str(), 0755);
+        baseline_path = spec_dir + "baselines/" + host + ".txt";
+    }
+
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(spec_path);
+        if (!file.is_open()) {
+            printf("[ERROR] Cannot read '%s'.\n", spec_path.c_str());
+            return 1;
+        }
+        std::string line;
+        while (std::getline(file, line)) lines.push_back(line);
+    }
+    std::vector<Run> runs;
+    std::string error;
+    if (!ParseSpec(lines, runs, error)) {
+        printf("[ERROR] %s: %s\n", spec_path.c_str(), error.c_str());
+        return 1;
+    }
+
+    // the replays only produce hashes, one worker per core
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    unsigned threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), runs.size()));
+    for (unsigned t = 0; t < threads; t ++) {
+        workers.emplace_back([&] {
+            for (size_t i; (i = next ++) < runs.size(); ) Replay(runs[i], rom_dir);
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+    // the timings run alone, so they do not share the CPU with each other,
+    // and take turns, so a burst of noise costs a run one repetition at most
+    for (int repeat = 0; repeat < PERF_REPEATS; repeat ++) {
+        for (Run &run : runs) {
+            if (run.error.empty()) Time(run);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::map<std::string, double> baseline;
+    if (!record) baseline = ReadBaseline(baseline_path); // --record starts over
+    int failed = 0;
+    int unknown = 0; // runs recorded now, as they had no baseline
+    // each run must stay within the tolerance, and so must the geometric
+    // mean, which catches a small slowdown across all of them
+    double log_ratios = 0;
+    int compared = 0;
+    for (Run &run : runs) {
+        std::vector<std::string> problems;
+        if (!run.error.empty()) problems.push_back(run.error);
+
+        for (const Check &check : run.checks) {
+            if (!run.error.empty()) break;
+            char text[128];
+            if (update) {
+                snprintf(text, sizeof(text), "check %llu %016llX",
+                         (unsigned long long)check.frame, (unsigned long long)check.got);
+                lines[check.line] = text;
+            } else if (!check.known) {
+                snprintf(text, sizeof(text), "frame %llu has no golden hash (make test-update)",
+                         (unsigned long long)check.frame);
+                problems.push_back(text);
+            } else if (check.got != check.hash) {
+                snprintf(text, sizeof(text), "frame %llu hash %016llX, expected %016llX",
+                         (unsigned long long)check.frame, (unsigned long long)check.got,
+                         (unsigned long long)check.hash);
+                problems.push_back(text);
+            }
+        }
+
+        char speed[128] = "";
+        if (run.error.empty()) {
+            auto known = baseline.find(RunName(run));
+            if (known == baseline.end()) {
+                baseline[RunName(run)] = run.instructions_per_sec;
+                snprintf(speed, sizeof(speed), "%7.1f M instr/s (recorded)", run.instructions_per_sec / 1e6);
+                unknown ++;
+            } else {
+                double ratio = run.instructions_per_sec / known->second;
+                snprintf(speed, sizeof(speed), "%7.1f M instr/s (%+.0f%% vs. baseline)",
+                         run.instructions_per_sec / 1e6, 100 * (ratio - 1));
+                if (100 * (ratio - 1) < -tolerance) {
+                    char text[128];
+                    snprintf(text, sizeof(text), "throughput %.0f%% below baseline, %.0f%% allowed",
+                             100 * (1 - ratio), tolerance);
+                    problems.push_back(text);
+                }
+                log_ratios += std::log(ratio);
+                compared ++;
+            }
+        }
+
+        printf("[%s] %-40s %zu frames  %s\n", problems.empty() ? "PASS" : "FAIL",
+               run.rom.c_str(), run.checks.size(), speed);
+        for (const std::string &problem : problems) printf("       %s\n", problem.c_str());
+        if (!problems.empty()) failed ++;
+    }
+
+    if (compared > 0) {
+        double change = 100 * (std::exp(log_ratios / compared) - 1);
+        bool slow = change < -tolerance;
+        printf("[%s] throughput %+.1f%% vs. baseline (geometric mean of %d runs, %.0f%% allowed)\n",
+               slow ? "FAIL" : "PASS", change, compared, tolerance);
+        if (slow) failed ++;
+    }
+    if (unknown > 0 && !record) {
+        printf("[WARN] %d runs had no baseline on this machine: recorded now, gated from the next run on\n",
+               unknown);
+    }
+
+    if (update && !WriteLines(spec_path, lines)) {
+        printf("[ERROR] Cannot write '%s'.\n", spec_path.c_str());
+        return 1;
+    }
+    if (unknown > 0) {
+        std::vector<std::string> out = { "# instructions/sec per run (seed, quirks, keys, frame, ROM) on this machine, written by chip8_test" };
+        for (auto &entry : baseline) {
+            char text[64];
+            snprintf(text, sizeof(text), "%.0f ", entry.second);
+            out.push_back(text + entry.first);
+        }
+        if (!WriteLines(baseline_path, out)) {
+            printf("[ERROR] Cannot write '%s'.\n", baseline_path.c_str());
+            return 1;
+        }
+        printf("Baseline written to %s\n", baseline_path.c_str());
+    }
+
+    printf("%zu runs in %.2f s (replayed on %u threads, timed one by one): %s\n", runs.size(), seconds, threads, failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#ifndef __RECOMPILED_H__
+#define __RECOMPILED_H__
+
+#include "../src/Chip8.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Symbols of a translation unit written by chip8_recompile
+
+extern const char    AOT_ROM_NAME[];
+extern const uint8_t AOT_ROM[];
+extern const size_t  AOT_ROM_SIZE;
+extern const size_t  AOT_BLOCK_COUNT;
+
+// run at least `budget` instructions (whole basic blocks at a time) and
+// return how many were executed; addresses without a compiled block,
+// indirect jumps and blocks whose bytes were overwritten at runtime go
+// through Chip8::Cycle(). Overwrites are only checked when a block is
+// entered: a block that stores into its own later instructions runs the
+// bytes it was compiled from until it returns to the dispatcher.
+uint64_t AOT_Run(Chip8 &chip8, uint64_t budget, bool &success);
+// forget runtime state kept between AOT_Run() calls (writes seen to the
+// ROM image); call it whenever the Chip8 is reset or the ROM reloaded
+void AOT_Reset();
+
+#endif // __RECOMPILED_H__
@@ -0,0 +1,77 @@
+// Headless runner for a ROM compiled by chip8_recompile
+
+#include "Recompiled.h"
+#include "../src/Chip8.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // memcmp(), strcmp()
+#include <stdexcept>
+#include <string>
+
+
+// compare everything a ROM can observe
+static bool SameState(const Chip8 &a, const Chip8 &b) {
+    return a.pc == b.pc && a.index == b.index && a.sp == b.sp && a.hires == b.hires
+        && a.delay_timer == b.delay_timer && a.sound_timer == b.sound_timer
+        && memcmp(a.registers, b.registers, sizeof(a.registers)) == 0
+        && memcmp(a.stack,     b.stack,     sizeof(a.stack))     == 0
+        && memcmp(a.memory,    b.memory,    sizeof(a.memory))    == 0
+        && memcmp(a.video,     b.video,     sizeof(a.video))     == 0
+        && memcmp(a.rpl,       b.rpl,       sizeof(a.rpl))       == 0;
+}
+
+int main(int argc, char** argv) {
+    uint64_t instructions = 100000000;
+    bool check = false;
+
+    for (int i = 1; i < argc; i ++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            try {
+                instructions = std::stoull(argv[i]);
+            } catch (std::logic_error const& ex) {
+                printf("Usage: %s [instructions] [--check]\n", argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    bool success = true;
+    Chip8 chip8;
+    chip8.LoadROM(AOT_ROM, AOT_ROM_SIZE, success);
+    AOT_Reset();
+    Chip8 reference = chip8; // same RNG state
+
+    printf("%s: %zu compiled blocks\n", AOT_ROM_NAME, AOT_BLOCK_COUNT);
+
+    const uint64_t slice = check ? 1 : 1000000;
+    uint64_t done = 0;
+    double seconds = 0;
+    while (success && done < instructions) {
+        auto start = std::chrono::high_resolution_clock::now();
+        uint64_t ran = AOT_Run(chip8, slice, success);
+        seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        done += ran;
+
+        if (check) {
+            for (uint64_t i = 0; i < ran && success; i ++) reference.Cycle(success);
+            if (!SameState(chip8, reference)) {
+                printf("[ERROR] Diverged from the interpreter after %llu instructions (pc=%03X).\n",
+                       (unsigned long long)done, reference.pc);
+                return 1;
+            }
+        }
+    }
+    if (!success) {
+        printf("[ERROR] Invalid pc value in runtime.\n");
+        return 1;
+    }
+
+    printf("%llu instructions in %.3f s (%.1f M/s), video hash %016llX\n",
+           (unsigned long long)done, seconds, done / seconds / 1e6,
+           (unsigned long long)chip8.VideoHash());
+    return 0;
+}
@@ -0,0 +1,361 @@
+// Ahead-of-time recompiler: ROM ==> C++ translation unit (see Recompiled.h)
+//
+// Control flow is recovered from START_ADDRESS by following 1nnn, 2nnn,
+// 00EE, skip opcodes and fall-through. Every basic block becomes a function
+// over the Chip8 state that returns the next pc. Opcodes with side effects
+// beyond registers go through Chip8::Execute() so the generated code keeps
+// the same semantics as the interpreter.
+
+#include "../src/Chip8.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+
+struct Block {
+    uint16_t              start;
+    std::vector<uint16_t> opcodes;
+};
+
+static std::vector<uint8_t> rom;
+
+static bool InROM(uint32_t address) {
+    return address >= START_ADDRESS && address + 1 < START_ADDRESS + rom.size()
+        && address % 2 == 0;
+}
+
+static uint16_t OpcodeAt(uint16_t address) {
+    return (rom[address - START_ADDRESS] << 8) | rom[address - START_ADDRESS + 1];
+}
+
+static bool IsSkip(uint16_t op) {
+    switch (op & 0xF000) {
+        case 0x3000:
+        case 0x4000: return true;
+        case 0x5000:
+        case 0x9000: return (op & 0x000F) == 0;
+        case 0xE000: return (op & 0x00FF) == 0x9E || (op & 0x00FF) == 0xA1;
+        default:     return false;
+    }
+}
+
+// opcode ends a basic block
+static bool IsTerminator(uint16_t op) {
+    return op == 0x00EE || op == 0x00FD || IsSkip(op)
+        || (op & 0xF000) == 0x1000 || (op & 0xF000) == 0x2000 || (op & 0xF000) == 0xB000
+        || (op & 0xF0FF) == 0xF00A;
+}
+
+// statically known successors of the instruction at `address`
+static std::vector<uint16_t> Successors(uint16_t address, uint16_t op) {
+    if (op == 0x00EE || (op & 0xF000) == 0xB000) return {}; // indirect
+    if (op == 0x00FD)                            return {}; // exit, stays put
+    if ((op & 0xF000) == 0x1000) return {(uint16_t)(op & 0x0FFF)};
+    if ((op & 0xF000) == 0x2000) return {(uint16_t)(op & 0x0FFF), (uint16_t)(address + 2)};
+    if (IsSkip(op))              return {(uint16_t)(address + 2), (uint16_t)(address + 4)};
+    return {(uint16_t)(address + 2)};
+}
+
+// walk all reachable instructions and split them into basic blocks
+static std::vector<Block> FindBlocks() {
+    std::set<uint16_t> reached;
+    std::set<uint16_t> leaders = {START_ADDRESS};
+    std::vector<uint16_t> worklist = {START_ADDRESS};
+
+    while (!worklist.empty()) {
+        uint16_t address = worklist.back();
+        worklist.pop_back();
+        if (!InROM(address) || reached.count(address)) continue;
+        reached.insert(address);
+
+        uint16_t op = OpcodeAt(address);
+        // a waiting Fx0A returns its own address, which must be a block
+        if ((op & 0xF0FF) == 0xF00A) leaders.insert(address);
+        for (uint16_t next : Successors(address, op)) {
+            if (IsTerminator(op)) leaders.insert(next);
+            worklist.push_back(next);
+        }
+    }
+
+    std::vector<Block> blocks;
+    for (uint16_t start : leaders) {
+        if (!reached.count(start)) continue;
+        Block block = {start, {}};
+        uint16_t address = start;
+        do {
+            uint16_t op = OpcodeAt(address);
+            block.opcodes.push_back(op);
+            address += 2;
+            if (IsTerminator(op)) break;
+        } while (reached.count(address) && !leaders.count(address));
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+
+// ******  code generation  ******
+static FILE* out;
+static int   pending_ticks; // instructions executed since the last Tick()
+
+static void FlushTicks() {
+    if (pending_ticks > 0) fprintf(out, "    Tick(c, %d);\n", pending_ticks);
+    pending_ticks = 0;
+}
+
+// emit one non-terminating instruction
+static void EmitInstruction(uint16_t op) {
+    uint8_t  x    = (op & 0x0F00) >> 8;
+    uint8_t  y    = (op & 0x00F0) >> 4;
+    uint8_t  kk   = op & 0x00FF;
+    uint16_t nnn  = op & 0x0FFF;
+
+    switch (op & 0xF000) {
+        case 0x6000: fprintf(out, "    c.registers[0x%X] = 0x%02X;\n", x, kk);                       break;
+        case 0x7000: fprintf(out, "    c.registers[0x%X] += 0x%02X;\n", x, kk);                      break;
+        case 0xA000: fprintf(out, "    c.index = 0x%03X;\n", nnn);                                    break;
+        case 0x8000:
+            switch (op & 0x000F) {
+                case 0x0: fprintf(out, "    c.registers[0x%X] = c.registers[0x%X];\n", x, y);     break;
+                case 0x1: fprintf(out, "    c.registers[0x%X] |= c.registers[0x%X];\n", x, y);    break;
+                case 0x2: fprintf(out, "    c.registers[0x%X] &= c.registers[0x%X];\n", x, y);    break;
+                case 0x3: fprintf(out, "    c.registers[0x%X] ^= c.registers[0x%X];\n", x, y);    break;
+                case 0x4: fprintf(out, "    Add(c, 0x%X, 0x%X);\n", x, y);                        break;
+                case 0x5: fprintf(out, "    Sub(c, 0x%X, 0x%X, 0x%X);\n", x, x, y);               break;
+                case 0x7: fprintf(out, "    Sub(c, 0x%X, 0x%X, 0x%X);\n", x, y, x);               break;
+                default:  fprintf(out, "    c.Execute(0x%04X);\n", op);                           break;
+            }
+            break;
+        case 0xF000:
+            switch (kk) {
+                case 0x07: FlushTicks();
+                           fprintf(out, "    c.registers[0x%X] = c.delay_timer;\n", x);           break;
+                case 0x15: FlushTicks();
+                           fprintf(out, "    c.delay_timer = c.registers[0x%X];\n", x);           break;
+                case 0x18: FlushTicks();
+                           fprintf(out, "    c.sound_timer = c.registers[0x%X];\n", x);           break;
+                case 0x1E: fprintf(out, "    c.index += c.registers[0x%X];\n", x);                break;
+                case 0x33: fprintf(out, "    Store(c, 0x%04X, 3);\n", op);                        break;
+                case 0x55: fprintf(out, "    Store(c, 0x%04X, %d);\n", op, x + 1);                break;
+                default:   fprintf(out, "    c.Execute(0x%04X);\n", op);                          break;
+            }
+            break;
+        default:
+            // 00E0, 8xy6, 8xyE, Cxkk, Dxyn, ... share the interpreter's handlers
+            fprintf(out, "    c.Execute(0x%04X);\n", op);
+            break;
+    }
+    pending_ticks ++;
+}
+
+// emit the last instruction of a block, which returns the next pc
+static void EmitTerminator(uint16_t address, uint16_t op) {
+    uint8_t  x    = (op & 0x0F00) >> 8;
+    uint8_t  y    = (op & 0x00F0) >> 4;
+    uint8_t  kk   = op & 0x00FF;
+    uint16_t next = address + 2;
+
+    pending_ticks ++;
+    switch (op & 0xF000) {
+        case 0x1000:
+            FlushTicks();
+            fprintf(out, "    return 0x%03X;\n", op & 0x0FFF);
+            return;
+        case 0x3000:
+        case 0x4000:
+            FlushTicks();
+            fprintf(out, "    return (c.registers[0x%X] %s 0x%02X) ? 0x%03X : 0x%03X;\n",
+                    x, ((op & 0xF000) == 0x3000) ? "==" : "!=", kk, next + 2, next);
+            return;
+        case 0x5000:
+        case 0x9000:
+            FlushTicks();
+            fprintf(out, "    return (c.registers[0x%X] %s c.registers[0x%X]) ? 0x%03X : 0x%03X;\n",
+                    x, ((op & 0xF000) == 0x5000) ? "==" : "!=", y, next + 2, next);
+            return;
+        case 0xE000: // Ex9E, ExA1
+            FlushTicks();
+            fprintf(out, "    return (c.keypad[c.registers[0x%X] & 0xF] %s 0) ? 0x%03X : 0x%03X;\n",
+                    x, (kk == 0x9E) ? "!=" : "==", next + 2, next);
+            return;
+        case 0xF000: // Fx0A, still waiting: back to this block (Fx0A always starts one)
+            FlushTicks();
+            fprintf(out, "    return WaitKey(c, 0x%X) ? 0x%03X : 0x%03X;\n", x, next, address);
+            return;
+        default:
+            // 00EE, 00FD, 2nnn, Bnnn: let the interpreter move pc
+            fprintf(out, "    c.pc = 0x%03X;\n", next);
+            fprintf(out, "    c.Execute(0x%04X);\n", op);
+            FlushTicks();
+            fprintf(out, "    return c.pc;\n");
+            return;
+    }
+}
+
+static void EmitBlock(const Block &block) {
+    fprintf(out, "// 0x%03X - 0x%03X\n", block.start,
+            (unsigned)(block.start + 2 * block.opcodes.size() - 2));
+    fprintf(out, "static uint16_t Block_%03X(Chip8 &c) {\n", block.start);
+
+    pending_ticks = 0;
+    uint16_t address = block.start;
+    for (size_t i = 0; i < block.opcodes.size(); i ++, address += 2) {
+        uint16_t op = block.opcodes[i];
+        if (i + 1 == block.opcodes.size() && IsTerminator(op)) {
+            EmitTerminator(address, op);
+            fprintf(out, "}\n\n");
+            return;
+        }
+        EmitInstruction(op);
+    }
+
+    // falls through into the next block
+    FlushTicks();
+    fprintf(out, "    return 0x%03X;\n}\n\n", address);
+}
+
+static void EmitPrologue(const std::string &rom_name, size_t block_count) {
+    fprintf(out, "// Generated by chip8_recompile, do not edit.\n\n");
+    fprintf(out, "#include \"Recompiled.h\"\n\n");
+    fprintf(out, "#include <cstdint>\n#include <cstring> // memcmp()\n\n");
+
+    fprintf(out, "const char AOT_ROM_NAME[] = \"");
+    for (char ch : rom_name) {
+        if (ch == '"' || ch == '\\') fputc('\\', out);
+        fputc(ch, out);
+    }
+    fprintf(out, "\";\n");
+
+    fprintf(out, "const uint8_t AOT_ROM[] = {");
+    for (size_t i = 0; i < rom.size(); i ++) {
+        fprintf(out, "%s0x%02X,", (i % 12 == 0) ? "\n    " : " ", rom[i]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out, "const size_t AOT_ROM_SIZE    = sizeof(AOT_ROM);\n");
+    fprintf(out, "const size_t AOT_BLOCK_COUNT = %zu;\n\n", block_count);
+
+    fprintf(out,
+        "static bool code_dirty = false; // a store hit the ROM image\n"
+        "\n"
+        "void AOT_Reset() {\n"
+        "    code_dirty = false;\n"
+        "}\n"
+        "\n"
+        "static inline void Tick(Chip8 &c, int n) {\n"
+        "    c.delay_timer = (c.delay_timer > n) ? c.delay_timer - n : 0;\n"
+        "    c.sound_timer = (c.sound_timer > n) ? c.sound_timer - n : 0;\n"
+        "}\n"
+        "\n"
+        "static inline void Add(Chip8 &c, int x, int y) {\n"
+        "    uint16_t sum = c.registers[x] + c.registers[y];\n"
+        "    c.registers[0xF] = (sum > 0xFF) ? 1 : 0;\n"
+        "    c.registers[x] = sum & 0xFF;\n"
+        "}\n"
+        "\n"
+        "// Vx = a - b, VF = NOT borrow\n"
+        "static inline void Sub(Chip8 &c, int x, int a, int b) {\n"
+        "    uint8_t flag = (c.registers[a] > c.registers[b]) ? 1 : 0;\n"
+        "    c.registers[0xF] = flag;\n"
+        "    c.registers[x] = c.registers[a] - c.registers[b];\n"
+        "}\n"
+        "\n"
+        "// Fx0A: Vx = lowest key held, false if none (pc stays on the Fx0A)\n"
+        "static inline bool WaitKey(Chip8 &c, int x) {\n"
+        "    for (int key = 0; key <= 0xF; key ++) {\n"
+        "        if (c.keypad[key]) {\n"
+        "            c.registers[x] = key;\n"
+        "            return true;\n"
+        "        }\n"
+        "    }\n"
+        "    return false;\n"
+        "}\n"
+        "\n"
+        "// note writes that land on the ROM image\n"
+        "static inline void Touch(uint16_t at, int length) {\n"
+        "    if (at < START_ADDRESS + AOT_ROM_SIZE && at + length > START_ADDRESS) code_dirty = true;\n"
+        "}\n"
+        "\n"
+        "static inline void Store(Chip8 &c, uint16_t op, int length) {\n"
+        "    uint16_t at = c.index;\n"
+        "    c.Execute(op);\n"
+        "    Touch(at, length);\n"
+        "}\n"
+        "\n"
+        "// block bytes no longer match the ROM it was compiled from\n"
+        "static inline bool Modified(const Chip8 &c, uint16_t start, int length) {\n"
+        "    return code_dirty\n"
+        "        && memcmp(&c.memory[start], &AOT_ROM[start - START_ADDRESS], length) != 0;\n"
+        "}\n\n");
+}
+
+static void EmitDispatcher(const std::vector<Block> &blocks) {
+    fprintf(out,
+        "uint64_t AOT_Run(Chip8 &c, uint64_t budget, bool &success) {\n"
+        "    uint64_t done = 0;\n"
+        "    while (done < budget) {\n"
+        "        switch (c.pc) {\n");
+    for (const Block &block : blocks) {
+        fprintf(out,
+            "            case 0x%03X:\n"
+            "                if (Modified(c, 0x%03X, %zu)) break;\n"
+            "                c.pc = Block_%03X(c);\n"
+            "                done += %zu;\n"
+            "                continue;\n",
+            block.start, block.start, 2 * block.opcodes.size(), block.start, block.opcodes.size());
+    }
+    fprintf(out,
+        "        }\n"
+        "\n"
+        "        // no compiled block here (or it was overwritten)\n"
+        "        uint16_t at = c.index;\n"
+        "        c.Cycle(success);\n"
+        "        if (!success) return done;\n"
+        "        if ((c.opcode & 0xF0FF) == 0xF033 || (c.opcode & 0xF0FF) == 0xF055) Touch(at, 16);\n"
+        "        done ++;\n"
+        "    }\n"
+        "    return done;\n"
+        "}\n");
+}
+// ******  end of: code generation  ******
+
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        printf("Usage: chip8_recompile <rom_file> <output.cpp>\n");
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file.is_open()) {
+        printf("Failed to open ROM file '%s'.\n", argv[1]);
+        return 1;
+    }
+    rom.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (rom.size() > 4096 - START_ADDRESS) {
+        printf("ROM file '%s' is too large.\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<Block> blocks = FindBlocks();
+
+    out = fopen(argv[2], "w");
+    if (out == nullptr) {
+        printf("Failed to open output file '%s'.\n", argv[2]);
+        return 1;
+    }
+    EmitPrologue(argv[1], blocks.size());
+    for (const Block &block : blocks) EmitBlock(block);
+    EmitDispatcher(blocks);
+    fclose(out);
+
+    size_t instructions = 0;
+    for (const Block &block : blocks) instructions += block.opcodes.size();
+    printf("%s: %zu blocks, %zu instructions\n", argv[1], blocks.size(), instructions);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Watch a running emulator started with `--spectate <socket>`:
+// decodes the frame stream (see src/Spectate.h) and draws it with plain
+// ANSI escapes, redrawing only the rows that changed.
+#include "../src/Quadrants.h"
+#include "../src/Spectate.h"
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // memcmp(), strncpy()
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define ROWS (VIDEO_HEIGHT / 2)
+#define COLS (VIDEO_WIDTH  / 2)
+
+
+// read exactly `size` bytes, false on EOF / error
+static bool ReadAll(int fd, uint8_t* buffer, size_t size) {
+    while (size > 0) {
+        ssize_t got = read(fd, buffer, size);
+        if (got <= 0) return false;
+        buffer += got;
+        size   -= got;
+    }
+    return true;
+}
+
+static int Pixel(const uint8_t* frame, int x, int y) {
+    return (frame[y * (VIDEO_WIDTH / 8) + x / 8] >> (7 - x % 8)) & 1;
+}
+
+static void Restore(int) {
+    fputs("\033[?25h\n", stdout); // show the cursor again
+    fflush(stdout);
+    _exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <socket>  (emulator started with --spectate <socket>)\n", argv[0]);
+        return 1;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Cannot connect to '%s'\n", argv[1]);
+        return 1;
+    }
+
+    uint8_t header[8];
+    if (!ReadAll(fd, header, sizeof(header)) || memcmp(header, SPECTATE_MAGIC, sizeof(SPECTATE_MAGIC)) != 0
+            || header[4] != SPECTATE_VERSION || header[5] != VIDEO_WIDTH || header[6] != VIDEO_HEIGHT) {
+        fprintf(stderr, "'%s' is not a compatible frame stream\n", argv[1]);
+        return 1;
+    }
+
+    const char* const* quadrants = Quadrants(); // as Platform::UpdateScreen()
+    signal(SIGINT,  Restore);
+    signal(SIGTERM, Restore);
+    fputs("\033[?25l\033[2J", stdout); // hide the cursor, clear
+
+    uint8_t frame[SPECTATE_FRAME_SIZE] = {};
+    std::string drawn[ROWS];
+    uint8_t message[3];
+    uint8_t bytes[0xFFFF];
+    while (ReadAll(fd, message, sizeof(message))) {
+        size_t size = (message[1] << 8) | message[2];
+        if (!ReadAll(fd, bytes, size)) break;
+        if (!ApplyMessage(message[0], bytes, size, frame)) {
+            fputs("\033[?25h\nCorrupt frame stream\n", stdout);
+            return 1;
+        }
+
+        for (int y = 0; y < ROWS; y ++) {
+            std::string line;
+            for (int x = 0; x < COLS; x ++) {
+                line += quadrants[Pixel(frame, 2 * x, 2 * y)           | Pixel(frame, 2 * x + 1, 2 * y) << 1
+                                | Pixel(frame, 2 * x, 2 * y + 1) << 2  | Pixel(frame, 2 * x + 1, 2 * y + 1) << 3];
+            }
+            if (drawn[y] == line) continue;
+            drawn[y] = line;
+            printf("\033[%d;1H%s", y + 1, line.c_str());
+        }
+        fflush(stdout);
+    }
+
+    printf("\033[%d;1H\033[?25hStream ended\n", ROWS + 1);
+    return 0;
+}
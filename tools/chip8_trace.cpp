@@ -0,0 +1,152 @@
+// Decode and filter execution traces written by `chip8_emulator --trace`
+
+#include "../src/Trace.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // strchr(), strcmp(), strlen()
+#include <map>
+#include <stdexcept>
+#include <string>
+
+
+static void Usage() {
+    printf("Usage: chip8_trace <trace_file> [options]\n");
+    printf("  --pc <addr>[-<addr>]   only records whose pc is in range\n");
+    printf("  --op <pattern>         only opcodes matching e.g. Dxyn, 8xy4, Fx33\n");
+    printf("                         (hex digits must match, x / y / n / k are wildcards)\n");
+    printf("  --from <n> --to <n>    only records [n, m) by position in the trace\n");
+    printf("                         (instructions lost in gaps still count)\n");
+    printf("  --stats                print per-opcode counts instead of records\n");
+}
+
+// turn an opcode pattern into mask/value, i.e. "Fx33" ==> mask F0FF, value F033
+static bool ParsePattern(const char* pattern, uint16_t &mask, uint16_t &value) {
+    if (strlen(pattern) != 4) return false;
+    mask = value = 0;
+    for (int i = 0; i < 4; i ++) {
+        char c = pattern[i];
+        int digit = -1;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        if (digit < 0 && !strchr("xynkXYNK", c)) return false;
+        mask  <<= 4;
+        value <<= 4;
+        if (digit >= 0) {
+            mask  |= 0xF;
+            value |= digit;
+        }
+    }
+    return true;
+}
+
+// group opcodes by their handler, i.e. 8124 ==> 8xy4
+static std::string OpcodeClass(uint16_t opcode) {
+    char name[5];
+    uint8_t high = opcode >> 12;
+    switch (high) {
+        case 0x0: snprintf(name, 5, "%04X", opcode);                         break;
+        case 0x5:
+        case 0x8:
+        case 0x9: snprintf(name, 5, "%Xxy%X", high, opcode & 0xF);           break;
+        case 0xD: snprintf(name, 5, "Dxyn");                                 break;
+        case 0xE:
+        case 0xF: snprintf(name, 5, "%Xx%02X", high, opcode & 0xFF);         break;
+        case 0x3:
+        case 0x4:
+        case 0x6:
+        case 0x7:
+        case 0xC: snprintf(name, 5, "%Xxkk", high);                          break;
+        default:  snprintf(name, 5, "%Xnnn", high);                          break;
+    }
+    return name;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        Usage();
+        return 1;
+    }
+
+    uint16_t pc_low = 0, pc_high = 0xFFFF;
+    uint16_t op_mask = 0, op_value = 0;
+    uint64_t from = 0, to = UINT64_MAX;
+    bool stats = false;
+
+    try {
+        for (int i = 2; i < argc; i ++) {
+            std::string arg = argv[i];
+            if (arg == "--pc" && i + 1 < argc) {
+                std::string range = argv[++ i];
+                size_t dash = range.find('-');
+                pc_low  = std::stoi(range.substr(0, dash), nullptr, 16);
+                pc_high = (dash == std::string::npos) ? pc_low
+                        : std::stoi(range.substr(dash + 1), nullptr, 16);
+            } else if (arg == "--op" && i + 1 < argc) {
+                if (!ParsePattern(argv[++ i], op_mask, op_value)) {
+                    printf("Invalid opcode pattern '%s'.\n", argv[i]);
+                    return 1;
+                }
+            } else if (arg == "--from" && i + 1 < argc) {
+                from = std::stoull(argv[++ i]);
+            } else if (arg == "--to" && i + 1 < argc) {
+                to = std::stoull(argv[++ i]);
+            } else if (arg == "--stats") {
+                stats = true;
+            } else {
+                Usage();
+                return 1;
+            }
+        }
+    } catch (std::logic_error const& ex) {
+        Usage();
+        return 1;
+    }
+
+    bool success = true;
+    TraceReader reader(argv[1], success);
+    if (!success) {
+        printf("Failed to open trace file '%s'.\n", argv[1]);
+        return 1;
+    }
+
+    std::map<std::string, uint64_t> counts;
+    TraceState state;
+    uint64_t lost = 0;
+    while (reader.Next(state)) {
+        uint64_t n = reader.position;
+        if (reader.lost != lost) {
+            // the writer fell behind and dropped records just before this one
+            if (!stats && n > from && n - (reader.lost - lost) < to) {
+                printf("%10s  ... %llu records lost (trace writer fell behind)\n", "",
+                       (unsigned long long)(reader.lost - lost));
+            }
+            lost = reader.lost;
+        }
+        if (n >= to) break;
+        if (n < from) continue;
+        if (state.pc < pc_low || state.pc > pc_high) continue;
+        if ((state.opcode & op_mask) != op_value) continue;
+
+        if (stats) {
+            counts[OpcodeClass(state.opcode)] ++;
+            continue;
+        }
+        printf("%10llu  pc=%03X  op=%04X  I=%03X  sp=%X  V=",
+               (unsigned long long)n, state.pc, state.opcode, state.index, state.sp);
+        for (int i = 0; i < 16; i ++) printf("%02X%s", state.registers[i], (i < 15) ? " " : "\n");
+    }
+
+    if (stats) {
+        for (const auto & entry : counts) {
+            printf("%s  %llu\n", entry.first.c_str(), (unsigned long long)entry.second);
+        }
+        if (lost > 0) printf("(%llu records lost in gaps)\n", (unsigned long long)lost);
+    }
+    if (reader.corrupt) {
+        printf("[ERROR] Corrupt trace after record %llu.\n", (unsigned long long)reader.position);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Compare Lockstep against the same number of plain Chip8 instances
+
+#include "../src/Chip8.h"
+#include "../src/Lockstep.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // memcmp()
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+const uint64_t STEPPED_CYCLES = 20000;        // per step size in the stepped check
+const uint64_t STEPS[]        = { 1, 7, 64 }; // Run() sizes that end mid-stint
+
+
+// what the lockstep engine must keep equal to a plain Chip8
+static bool SameLane(const Chip8 &a, const Chip8 &b) {
+    return a.pc == b.pc && a.index == b.index && a.delay_timer == b.delay_timer
+        && memcmp(a.registers, b.registers, sizeof(a.registers)) == 0
+        && memcmp(a.memory,    b.memory,    sizeof(a.memory))    == 0
+        && memcmp(a.video,     b.video,     sizeof(a.video))     == 0;
+}
+
+// Run() in small steps against scalar instances, compared after every call,
+// so state handed back at the end of each call is checked too; returns the
+// cycle after which a lane first differed, 0 if none did
+static uint64_t SteppedCheck(const std::vector<uint8_t> &rom, int lanes, uint64_t step, bool &success) {
+    Lockstep engine(lanes);
+    engine.LoadROM(rom.data(), rom.size(), success);
+    std::vector<Chip8> scalar(lanes);
+    for (int i = 0; i < lanes; i ++) {
+        scalar[i].Seed(i);
+        scalar[i].LoadROM(rom.data(), rom.size(), success);
+    }
+
+    for (uint64_t done = 0; done < STEPPED_CYCLES && success; done += step) {
+        engine.Run(step, success);
+        for (int i = 0; i < lanes; i ++) {
+            for (uint64_t j = 0; j < step && success; j ++) scalar[i].Cycle(success);
+            if (!SameLane(scalar[i], engine.Lane(i))) return done + step;
+        }
+    }
+    return 0;
+}
+
+static double Seconds(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: chip8_lockstep_bench <rom_file> [lanes] [cycles]\n");
+        return 1;
+    }
+
+    int lanes = LOCKSTEP_MAX_LANES;
+    uint64_t cycles = 1000000;
+    try {
+        if (argc > 2) lanes  = std::stoi(argv[2]);
+        if (argc > 3) cycles = std::stoull(argv[3]);
+    } catch (std::logic_error const& ex) {
+        printf("Invalid lanes/cycles.\n");
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (rom.empty()) {
+        printf("Failed to open ROM file '%s'.\n", argv[1]);
+        return 1;
+    }
+
+    bool success = true;
+    Lockstep engine(lanes);
+    lanes = engine.Lanes();
+    engine.LoadROM(rom.data(), rom.size(), success);
+
+    // scalar instances with the same seeds as the lanes
+    std::vector<Chip8> scalar(lanes);
+    for (int i = 0; i < lanes; i ++) {
+        scalar[i].Seed(i);
+        scalar[i].LoadROM(rom.data(), rom.size(), success);
+    }
+    if (!success) {
+        printf("Failed to load ROM file '%s'.\n", argv[1]);
+        return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (Chip8 &chip : scalar) {
+        for (uint64_t i = 0; i < cycles && success; i ++) chip.Cycle(success);
+    }
+    double scalar_time = Seconds(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    engine.Run(cycles, success);
+    double lockstep_time = Seconds(start);
+
+    if (!success) {
+        printf("[ERROR] Invalid pc value in runtime.\n");
+        return 1;
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < lanes; i ++) {
+        if (!SameLane(scalar[i], engine.Lane(i))) mismatches ++;
+    }
+
+    double total = (double)cycles * lanes;
+    printf("%d lanes x %llu cycles\n", lanes, (unsigned long long)cycles);
+    printf("  scalar:   %8.1f M instr/s\n", total / scalar_time / 1e6);
+    printf("  lockstep: %8.1f M instr/s (%.1f%% of cycles in lockstep)\n",
+           total / lockstep_time / 1e6,
+           100.0 * engine.vector_cycles / (engine.vector_cycles + engine.scalar_cycles));
+    if (mismatches > 0) {
+        printf("[ERROR] %d lanes differ from their scalar instance.\n", mismatches);
+        return 1;
+    }
+
+    for (uint64_t step : STEPS) {
+        uint64_t differs = SteppedCheck(rom, lanes, step, success);
+        if (!success) {
+            printf("[ERROR] Invalid pc value in runtime.\n");
+            return 1;
+        }
+        if (differs > 0) {
+            printf("[ERROR] Run(%llu) steps: a lane differs from its scalar instance after %llu cycles.\n",
+                   (unsigned long long)step, (unsigned long long)differs);
+            return 1;
+        }
+    }
+    printf("  Run() in steps of 1, 7, 64: same as scalar\n");
+    return 0;
+}